@@ -35,7 +35,10 @@ namespace maiken {
 class Application;
 }
 
+#include <mutex>
 #include <optional>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "maiken/defs.hpp"
 
@@ -81,6 +84,7 @@ class KUL_PUBLISH Application : public Constants {
   friend class ThreadingCompiler;
   friend class Project;
   friend class Processor;
+  friend class Properties;
 
  public:
   using SourceMap = kul::hash::map::S2T<kul::hash::map::S2T<std::vector<maiken::Source>>>;
@@ -104,12 +108,10 @@ class KUL_PUBLISH Application : public Constants {
   static void parseDependencyString(std::string s, kul::hash::set::String& include);
 
   void compile(kul::hash::set::String& objects) KTHROW(kul::Exception);
+  // "vars" in place of the global application state, as a node's sessions each have their own
   void compile(std::vector<std::pair<maiken::Source, std::string>>& src_objs,
-               kul::hash::set::String& objects, std::vector<kul::File>& cacheFiles)
-      KTHROW(kul::Exception);
-  void compile(std::queue<std::pair<maiken::Source, std::string>>& src_objs,
-               kul::hash::set::String& objects, std::vector<kul::File>& cacheFiles)
-      KTHROW(kul::Exception);
+               kul::hash::set::String& objects, std::vector<kul::File>& cacheFiles,
+               AppVars const& vars = AppVars::INSTANCE()) KTHROW(kul::Exception);
   void build() KTHROW(kul::Exception);
   void pack() KTHROW(kul::Exception);
   void findObjects(kul::hash::set::String& objects) const;
@@ -121,6 +123,17 @@ class KUL_PUBLISH Application : public Constants {
   void scmUpdate(bool const& f) KTHROW(kul::scm::Exception);
   void scmUpdate(bool const& f, const kul::SCM* scm, std::string const& repo)
       KTHROW(kul::scm::Exception);
+  // -U for applications found together
+  static void SCM_UPDATE(std::vector<Application*> const& apps) KTHROW(kul::scm::Exception);
+  // copies the repositories of dependencies into settings local/mirror
+  static void SCM_MIRROR(std::vector<Application*> const& apps) KTHROW(kul::Exception);
+  std::string scmSource() const;
+  std::string scmVersion() const;
+  // "UPDATING: " line announcing an update from "url"
+  std::string scmUpdating(std::string const& url) const;
+  // updates from "url" and returns the output
+  std::string scmUp(const kul::SCM* scm, std::string const& url) const
+      KTHROW(kul::scm::Exception);
 
   void setup() KTHROW(kul::Exception);
   void setSuper();
@@ -140,8 +153,10 @@ class KUL_PUBLISH Application : public Constants {
 
   void populateMapsFromDependencies() KTHROW(kul::Exception);
 
-  void loadDepOrMod(YAML::Node const& node, const kul::Dir& depOrMod, bool module)
+  void fetchDepOrMod(YAML::Node const& node, const kul::Dir& depOrMod, bool module)
       KTHROW(kul::Exception);
+  void loadDepOrMod(YAML::Node const& node, const kul::Dir& depOrMod, bool module,
+                    bool fetched = 0) KTHROW(kul::Exception);
   kul::Dir resolveDepOrModDirectory(YAML::Node const& d, bool module);
   void popDepOrMod(YAML::Node const& n, std::vector<Application*>& vec, std::string const& s,
                    bool module, bool with = 0) KTHROW(kul::Exception);
@@ -266,7 +281,10 @@ class KUL_PUBLISH Application : public Constants {
     std::string n = project().root()[STR_NAME].Scalar();
     return out.empty() ? inst ? p.empty() ? n : n + "_" + p : n : out;
   }
-  SourceMap sourceMap() const;
+  // built on first use, reused until forgetSourceMap after sources or mains change, holders
+  //  keep the map they were given
+  std::shared_ptr<SourceMap const> sourceMap() const;
+  void forgetSourceMap() const;
 
   static std::vector<Application*> CREATE(kul::cli::Args const& args) KTHROW(kul::Exception);
   static std::vector<Application*> CREATE(int16_t argc, char* argv[]) KTHROW(kul::Exception);
@@ -306,6 +324,11 @@ class KUL_PUBLISH Application : public Constants {
   std::vector<std::pair<maiken::Source, bool>> srcs;
   std::vector<std::pair<std::string, bool>> incs;
   const kul::SCM* scm = 0;
+  // Properties::RESOLVE results by input, cleared when properties are resolved again
+  mutable std::mutex resolved_mute;
+  mutable std::unordered_map<std::string, std::string> resolved;
+  mutable std::mutex sm_mute;
+  mutable std::shared_ptr<SourceMap const> sm;
 };
 
 class Applications : public Constants {
@@ -324,6 +347,23 @@ class Applications : public Constants {
 
   Application* getOrNullptr(std::string const& project);
 
+  // later lookups for the project in "dir" create new applications, the existing ones are handed
+  //  to the caller and stay valid while it keeps them
+  std::vector<std::unique_ptr<Application>> forget(std::string const& dir) {
+    std::vector<std::unique_ptr<Application>> forgotten;
+    if (!m_apps.count(dir)) return forgotten;
+    std::unordered_set<Application const*> apps;
+    for (auto const& profile : m_apps.at(dir)) apps.insert(profile.second);
+    m_apps.erase(dir);
+    for (auto it = m_appPs.begin(); it != m_appPs.end();)
+      if (apps.count(it->get())) {
+        forgotten.emplace_back(std::move(*it));
+        it = m_appPs.erase(it);
+      } else
+        ++it;
+    return forgotten;
+  }
+
   std::vector<Application const*> applicationsFor(Project const& project) const {
     std::vector<Application const*> ret;
     for (auto const& profile : m_apps.at(project.dir().real())) ret.emplace_back(profile.second);
@@ -342,23 +382,36 @@ class Applications : public Constants {
 
 class ThreadingCompiler : public Constants {
  private:
+  // compiler and arguments common to every unit of one file type, built on first use
+  struct Template {
+    std::string compiler;
+    Compiler const* comp = nullptr;
+    std::shared_ptr<std::vector<std::string> const> args;
+  };
+
   maiken::Application& app;
-  std::vector<std::string> incs;
+  AppVars const& vars;
+  std::shared_ptr<std::vector<std::string>> incs, fincs;
+  mutable std::mutex mute;
+  mutable std::unordered_map<std::string, Template> templates;
+
+  Template const& templateFor(std::string const& fileType) const KTHROW(kul::Exception);
 
  public:
-  ThreadingCompiler(maiken::Application& app) : app(app) {
+  ThreadingCompiler(maiken::Application& app, AppVars const& vars = AppVars::INSTANCE())
+      : app(app),
+        vars(vars),
+        incs(std::make_shared<std::vector<std::string>>()),
+        fincs(std::make_shared<std::vector<std::string>>()) {
     for (auto const& s : app.includes()) {
-      std::string m;
       kul::Dir d(s.first);
       kul::File f(s.first);
       if (d)
-        m = (AppVars::INSTANCE().dryRun() ? d.esc() : d.escm());
+        incs->push_back(vars.dryRun() ? d.esc() : d.escm());
       else if (f)
-        m = (AppVars::INSTANCE().dryRun() ? f.esc() : f.escm());
-      if (!m.empty())
-        incs.push_back(m);
+        fincs->push_back(vars.dryRun() ? f.esc() : f.escm());
       else
-        incs.push_back(".");
+        incs->push_back(".");
     }
   }
 
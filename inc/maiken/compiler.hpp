@@ -53,7 +53,9 @@ struct CompilationInfo {
 
 namespace compiler {
 enum Mode { NONE = 0, STAT, SHAR };
-}
+// where compilerTimeTrace() output goes, a report on stderr or a json file by the object
+enum class TimeTrace_Type : uint16_t { NON = 0, REPORT = 1, JSON = 2 };
+}  // namespace compiler
 
 struct CompileDAO {
   maiken::Application const& app;
@@ -61,6 +63,9 @@ struct CompileDAO {
   std::vector<std::string> const &args, &incs;
   compiler::Mode const& mode;
   bool dryRun = false;
+  // if set "incs" are known directories and these are forced includes, nothing is checked on disk
+  std::vector<std::string> const* includeFiles = nullptr;
+  bool preprocess = false;  // "out" is the preprocessed source rather than an object
 };
 struct LinkDAO {
   maiken::Application const& app;
@@ -77,6 +82,10 @@ class CompilerProcessCapture : public kul::ProcessCapture {
   CompilerProcessCapture(kul::AProcess& p) : kul::ProcessCapture(p) {}
 
   void exception(std::exception_ptr const& e) { ep = e; }
+  void capture(std::string const& o, std::string const& e) {
+    out(o);
+    err(e);
+  }
   std::exception_ptr const& exception() const { return ep; }
 
   void cmd(std::string const& cm) { this->c = cm; }
@@ -112,6 +121,10 @@ class Compiler {
                                 std::string const& out, bool dryRun = false) const
       KTHROW(kul::Exception) = 0;
 
+  // flag to profile a single compilation, empty if unsupported
+  virtual std::string compilerTimeTrace() const { return ""; }
+  virtual compiler::TimeTrace_Type timeTraceType() const { return compiler::TimeTrace_Type::NON; }
+
   std::string compilerDebug(uint8_t const& key) const {
     return m_debug_c.count(key) ? m_debug_c.at(key) : "";
   }
@@ -136,8 +149,10 @@ class Compiler {
 };
 
 struct CompilationUnit {
+  using Strings = std::shared_ptr<std::vector<std::string> const>;
+
   CompilationUnit(maiken::Application const& app, Compiler const* comp, std::string const& compiler,
-                  std::vector<std::string> const& args, std::vector<std::string> const& incs,
+                  Strings const& args, Strings const& incs, Strings const& fincs,
                   std::string const& in, std::string const& out, compiler::Mode const& mode,
                   bool dryRun)
       : app(app),
@@ -145,6 +160,7 @@ struct CompilationUnit {
         compiler(compiler),
         args(args),
         incs(incs),
+        fincs(fincs),
         in(in),
         out(out),
         mode(mode),
@@ -154,11 +170,18 @@ struct CompilationUnit {
 
   std::string compileString() const KTHROW(kul::Exception);
 
+  // writes the preprocessed source to "file"
+  CompilerProcessCapture preprocess(std::string const& file) const KTHROW(kul::Exception);
+
+  // command compiling preprocessed "_in" to "_out", includes are not needed
+  std::string compileString(std::string const& _in, std::string const& _out) const
+      KTHROW(kul::Exception);
+
   maiken::Application const& app;
   Compiler const* comp;
   std::string const compiler;
-  std::vector<std::string> const args;
-  std::vector<std::string> const incs;
+  // shared between units of the same application and file type unless the source has own args
+  Strings const args, incs, fincs;
   std::string const in;
   std::string const out;
   compiler::Mode const mode;
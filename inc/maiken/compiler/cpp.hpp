@@ -97,10 +97,17 @@ class GccCompiler : public CCompiler {
       KTHROW(kul::Exception) override;
 
   CCompiler_Type type() const override { return CCompiler_Type::GCC; }
+  std::string compilerTimeTrace() const override { return "-ftime-report"; }
+  compiler::TimeTrace_Type timeTraceType() const override {
+    return compiler::TimeTrace_Type::REPORT;
+  }
 
   void rpathing(maiken::Application const& app, kul::Process& p, kul::File const& out,
                 std::vector<std::string> const& libs,
                 std::vector<std::string> const& libPaths) const;
+
+ protected:
+  CompilerProcessCapture buildArchive(LinkDAO& dao) const KTHROW(kul::Exception);
 };
 
 class ClangCompiler : public GccCompiler {
@@ -109,6 +116,10 @@ class ClangCompiler : public GccCompiler {
   std::string cc() const override { return CC("clang"); }
   std::string cxx() const override { return CXX("clang++"); }
   CCompiler_Type type() const override { return CCompiler_Type::CLANG; }
+  std::string compilerTimeTrace() const override { return "-ftime-trace"; }
+  compiler::TimeTrace_Type timeTraceType() const override {
+    return compiler::TimeTrace_Type::JSON;
+  }
 };
 
 class HccCompiler : public GccCompiler {
@@ -117,6 +128,10 @@ class HccCompiler : public GccCompiler {
   std::string cc() const override { return CC("hcc"); }
   std::string cxx() const override { return CXX("h++"); }
   CCompiler_Type type() const override { return CCompiler_Type::HCC; }
+  std::string compilerTimeTrace() const override { return ""; }
+  compiler::TimeTrace_Type timeTraceType() const override {
+    return compiler::TimeTrace_Type::NON;
+  }
 };
 
 class IntelCompiler : public GccCompiler {
@@ -125,6 +140,10 @@ class IntelCompiler : public GccCompiler {
   std::string cc() const override { return CC("icc"); }
   std::string cxx() const override { return CXX("icpc"); }
   CCompiler_Type type() const override { return CCompiler_Type::ICC; }
+  std::string compilerTimeTrace() const override { return ""; }
+  compiler::TimeTrace_Type timeTraceType() const override {
+    return compiler::TimeTrace_Type::NON;
+  }
 };
 
 class WINCompiler : public CCompiler {
@@ -53,6 +53,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define _MKN_REMOTE_EXEC_ 1
 #endif /* _MKN_REMOTE_EXEC_ */
 
+#ifndef _MKN_SCM_SHALLOW_
+#define _MKN_SCM_SHALLOW_ 1
+#endif /* _MKN_SCM_SHALLOW_ */
+
 #ifndef _MKN_REMOTE_REPO_
 #define _MKN_REMOTE_REPO_ "https://github.com/mkn/ https://gitlab.com/mkn/"
 #endif /* _MKN_REMOTE_REPO_ */
@@ -95,6 +99,8 @@ class Constants {
   static constexpr auto STR_PACK = "pack";
   static constexpr auto STR_THREADS = "threads";
   static constexpr auto STR_TREE = "tree";
+  static constexpr auto STR_COST = "cost";
+  static constexpr auto STR_MIRROR = "mirror";
 
   static constexpr auto STR_SCM_COMMIT = "scm-commit";
   static constexpr auto STR_SCM_STATUS = "scm-status";
@@ -122,6 +128,7 @@ class Constants {
   static constexpr auto STR_PROJECT = "project";
   static constexpr auto STR_LOCAL = "local";
   static constexpr auto STR_REMOTE = "remote";
+  static constexpr auto STR_TTL = "ttl";
   static constexpr auto STR_SCM = "scm";
   static constexpr auto STR_SELF = "self";
   static constexpr auto STR_PROFILE = "profile";
@@ -176,8 +183,10 @@ class Constants {
   static constexpr auto STR_WITHOUT = "without";
 
   static constexpr auto STR_RUN_ARG = "run-arg";
+  static constexpr auto STR_TIME_TRACE = "time-trace";
 
   static constexpr auto STR_DIR = "directory";
+  static constexpr auto STR_PORT = "port";
   static constexpr auto STR_SETTINGS = "settings";
 
   static constexpr auto STR_IF_DEP = "if_dep";
@@ -32,7 +32,14 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define _MAIKEN_DIST_HPP_
 #if defined(_MKN_WITH_MKN_RAM_) && defined(_MKN_WITH_IO_CEREAL_)
 
+#include <cctype>
+#include <cstdio>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
 #include <memory>
+#include <random>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -68,55 +75,19 @@ class RemoteCommandManager;
 class Server;
 }  // namespace dist
 
+// Linked binaries are sent to every node so they can link dependents, as chunks the node does
+//  not already hold
 class DistLinker {
  public:
-  static void send([[maybe_unused]] kul::File const& bin) {
-#if defined(_MKN_WITH_MKN_RAM_) && defined(_MKN_WITH_IO_CEREAL_)
-    std::vector<std::shared_ptr<maiken::dist::Post>> posts;
-    auto post_lambda = [](const dist::Host& host, kul::File const& bin) {
-      kul::io::BinaryReader br(bin);
-      dist::Blob b;
-      b.files_left = 1;
-      b.file = bin.real();
-      size_t red = 0;
-      do {
-        bzero(b.c1, dist::BUFF_SIZE / 2);
-        red = b.len = br.read(b.c1, dist::BUFF_SIZE / 2);
-        if (red == 0) {
-          b.last_packet = 1;
-          b.files_left = 0;
-        }
-        std::ostringstream ss(std::ios::out | std::ios::binary);
-        {
-          cereal::PortableBinaryOutputArchive oarchive(ss);
-          oarchive(b);
-        }
-        auto link = std::make_shared<maiken::dist::Post>(
-            maiken::dist::RemoteCommandManager::INST().build_link_request(ss.str()));
-        link->send(host);
-      } while (red > 0);
-    };
-
-    auto& hosts(maiken::dist::RemoteCommandManager::INST().hosts());
-    size_t threads = hosts.size();
-    kul::ChroncurrentThreadPool<> ctp(threads, 1, 1000000, 1000);
-    auto post_ex = [&](kul::Exception const& e) {
-      ctp.stop().interrupt();
-      throw e;
-    };
-    for (size_t i = 0; i < threads; i++) {
-      ctp.async(std::bind(post_lambda, std::ref(hosts[i]), std::ref(bin)), post_ex);
-    }
-    ctp.finish(10000000);  // 10 milliseconds
-    ctp.rethrow();
-#endif  //  _MKN_WITH_MKN_RAM_) && defined(_MKN_WITH_IO_CEREAL_)
-  }
+  static void send(kul::File const& bin) KTHROW(kul::Exception);
 };
 
 }  // namespace maiken
 
+#include "maiken/dist/codec.hpp"
 #include "maiken/dist/message.hpp"
 #include "maiken/dist/server.hpp"
+#include "maiken/dist/queue.hpp"
 
 namespace maiken {
 class Application;
@@ -124,16 +95,55 @@ namespace dist {
 
 class Host {
  private:
-  uint16_t m_port;
+  // as last reported by the node
+  struct Status {
+    std::atomic<bool> alive{1}, excluded{0};
+    std::atomic<uint16_t> cores{1}, load{0};
+  };
+
+  uint16_t m_port, m_threads, m_compression;
+  bool m_preprocess;
   std::string m_host;
+  std::shared_ptr<Status> m_status = std::make_shared<Status>();
 
  public:
-  Host(std::string host, uint16_t port) : m_port(port), m_host(host) {}
+  Host(std::string host, uint16_t port, uint16_t threads = 0, uint16_t compression = 0,
+       bool preprocess = false)
+      : m_port(port),
+        m_threads(threads),
+        m_compression(std::min(compression, Codec::MAX_LEVEL)),
+        m_preprocess(preprocess),
+        m_host(host) {}
   std::string const& host() const { return m_host; }
   uint16_t const& port() const { return m_port; }
+  // compilation units given to this host at once, from settings or the node's idle cores
+  uint16_t threads() const {
+    if (m_threads) return m_threads;
+    uint16_t const cores = m_status->cores, load = m_status->load;
+    return cores > load ? cores - load : 1;
+  }
+  // answering heartbeats
+  bool alive() const { return m_status->alive && !m_status->excluded; }
+  void alive(bool const a) const { m_status->alive = a; }
+  // failed the handshake, not used for this build
+  bool excluded() const { return m_status->excluded; }
+  void exclude() const { m_status->excluded = 1; }
+  void capacity(uint16_t const cores, uint16_t const load) const {
+    m_status->cores = cores ? cores : 1;
+    m_status->load = load;
+  }
+  // payload compression level, 0 is off
+  uint16_t const& compression() const { return m_compression; }
+  // sources are preprocessed here and sent, the node needs no copy of the project
+  bool const& preprocess() const { return m_preprocess; }
+  // distinct per client process, one node may serve many clients at once, names a directory
+  //  on the node so holds only what PreprocessedUnit::VALID_BLOB allows
   std::string const session_id() const {
+    static uint64_t const token =
+        (uint64_t{std::random_device{}()} << 32) | uint64_t{std::random_device{}()};
     std::stringstream ss;
-    ss << std::hex << m_host << this;
+    ss << std::hex << PreprocessedUnit::HASH(m_host.data(), m_host.size()) << "-"
+       << reinterpret_cast<uintptr_t>(this) << "-" << token;
     return ss.str();
   }
 };
@@ -148,7 +158,8 @@ class Post {
 
   explicit Post(std::unique_ptr<ARequest> _msg) : msg(std::move(_msg)) {}
   void send(const Host& host) KTHROW(Exception) {
-    send(host.host(), "res", host.port(), {{"session", host.session_id()}});
+    send(host.host(), "res", host.port(),
+         {{"session", host.session_id()}, {"compress", std::to_string(host.compression())}});
   }
   void send(std::string const& host, std::string const& res, uint16_t const& port,
             const std::unordered_map<std::string, std::string> headers = {{}})
@@ -189,15 +200,32 @@ class RemoteCommandManager {
       std::string const& directory,
       const std::vector<std::pair<std::string, std::string>>& src_obj);
 
+  std::unique_ptr<CompileRequest> build_compile_request(
+      std::vector<PreprocessedUnit> const& units);
+
+  std::unique_ptr<ManifestRequest> build_manifest_request(std::vector<std::string> const& blobs);
+
+  std::unique_ptr<UploadRequest> build_upload_request(std::string const& b);
+
   std::unique_ptr<DownloadRequest> build_download_request();
 
-  std::unique_ptr<LinkRequest> build_link_request(std::string const& b);
+  std::unique_ptr<StatusRequest> build_status_request(std::vector<std::string> const& compilers);
+
+  std::unique_ptr<LinkRequest> build_link_request(std::string const& file,
+                                                 std::vector<std::string> const& chunks);
 
   void build_hosts(const Settings& settings) KTHROW(kul::Exception) {
     if (settings.root()["dist"]) {
-      if (settings.root()["dist"]["nodes"]) {
-        for (auto const& node : settings.root()["dist"]["nodes"]) {
-          m_hosts.emplace_back(node["host"].Scalar(), kul::String::UINT16(node["port"].Scalar()));
+      auto const& dist = settings.root()["dist"];
+      uint16_t const compression =
+          dist["compress"] ? kul::String::UINT16(dist["compress"].Scalar()) : 1;
+      if (dist["nodes"]) {
+        for (auto const& node : dist["nodes"]) {
+          bool const preprocess =
+              node["preprocess"] && kul::String::BOOL(node["preprocess"].Scalar());
+          m_hosts.emplace_back(node["host"].Scalar(), kul::String::UINT16(node["port"].Scalar()),
+                               node["threads"] ? kul::String::UINT16(node["threads"].Scalar()) : 0,
+                               compression, preprocess);
         }
       }
     }
@@ -208,6 +236,66 @@ class RemoteCommandManager {
   std::vector<Host> m_hosts;
 };
 using RMC = RemoteCommandManager;
+
+// Nodes are asked for their capacity and compilers before use, then sent a heartbeat while
+//  compiling. A node that stops answering is marked down, its units go back to the work queue
+//  and it is used again once it answers.
+class NodeMonitor {
+ public:
+  // false if the node cannot be reached or its compilers differ from ours
+  static bool HANDSHAKE(Application const& app, Host const& host);
+
+  NodeMonitor(std::vector<Host> const& hosts, size_t const n);
+  ~NodeMonitor();
+
+  NodeMonitor(const NodeMonitor&) = delete;
+  NodeMonitor& operator=(const NodeMonitor&) = delete;
+
+ private:
+  // updates the host from the node's reply
+  static YAML::Node STATUS(Host const& host, std::vector<std::string> const& compilers);
+
+  // sends a heartbeat to "host" every two seconds until the monitor is destroyed
+  void beat(Host const& host);
+
+  std::atomic<bool> running{1};
+  std::mutex mute;
+  std::condition_variable cv;
+  std::vector<std::thread> threads;
+};
+
+// Content addressed blobs in a node's store, shared by preprocessed units and binary chunks
+class Store {
+ public:
+  // "<fnv-1a>-<size>"
+  static std::string HASH(uint8_t const* data, size_t const len);
+  // as HASH, from an FNV-1a hash and size already computed
+  static std::string NAME(uint64_t const hash, size_t const len);
+
+  // blobs the node does not have
+  static std::vector<std::string> MISSING(Host const& host, std::vector<std::string> const& blobs)
+      KTHROW(kul::Exception);
+
+  static void UPLOAD(Host const& host, std::string const& blob, uint8_t const* data,
+                     size_t const len) KTHROW(kul::Exception);
+
+  // content defined boundaries as offset and length, so an edit only changes nearby chunks
+  static std::vector<std::pair<size_t, size_t>> CHUNKS(uint8_t const* data, size_t const len);
+
+  static std::vector<uint8_t> READ(kul::File const& file) KTHROW(kul::Exception);
+};
+
+// Remote compilation for nodes without the project. Units are preprocessed locally and their
+//  output offered by content hash, only what the node has not seen before is uploaded.
+class Preprocessor {
+ public:
+  using Unit = std::pair<maiken::Source, std::string>;
+
+  // empty if a unit's compiler cannot preprocess separately
+  static std::vector<PreprocessedUnit> PREPARE(Application& app, Host const& host,
+                                               std::vector<Unit> const& batch)
+      KTHROW(kul::Exception);
+};
 }  // end namespace dist
 }  // end namespace maiken
 
@@ -223,6 +311,18 @@ CEREAL_SPECIALIZE_FOR_ALL_ARCHIVES(maiken::dist::CompileRequest,
                                    cereal::specialization::member_serialize)
 CEREAL_REGISTER_TYPE(maiken::dist::CompileRequest)
 
+CEREAL_SPECIALIZE_FOR_ALL_ARCHIVES(maiken::dist::ManifestRequest,
+                                   cereal::specialization::member_serialize)
+CEREAL_REGISTER_TYPE(maiken::dist::ManifestRequest)
+
+CEREAL_SPECIALIZE_FOR_ALL_ARCHIVES(maiken::dist::UploadRequest,
+                                   cereal::specialization::member_serialize)
+CEREAL_REGISTER_TYPE(maiken::dist::UploadRequest)
+
+CEREAL_SPECIALIZE_FOR_ALL_ARCHIVES(maiken::dist::StatusRequest,
+                                   cereal::specialization::member_serialize)
+CEREAL_REGISTER_TYPE(maiken::dist::StatusRequest)
+
 CEREAL_SPECIALIZE_FOR_ALL_ARCHIVES(maiken::dist::DownloadRequest,
                                    cereal::specialization::member_serialize)
 CEREAL_REGISTER_TYPE(maiken::dist::DownloadRequest)
@@ -0,0 +1,54 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef _MAIKEN_DIST_CODEC_HPP_
+#define _MAIKEN_DIST_CODEC_HPP_
+
+namespace maiken {
+namespace dist {
+
+// LZ77 block codec for dist payloads, every level produces the same format
+//  higher levels search further back for longer matches at the cost of speed
+class Codec {
+ public:
+  static constexpr uint16_t MAX_LEVEL = 9;
+
+  // returns compressed length written to "out", or 0 if it would not be smaller than "len"
+  //  "out" must hold at least "len" bytes
+  static size_t COMPRESS(uint16_t level, uint8_t const* in, size_t len, uint8_t* out);
+
+  static void DECOMPRESS(uint8_t const* in, size_t len, uint8_t* out, size_t out_len)
+      KTHROW(Exception);
+};
+
+}  // end namespace dist
+}  // end namespace maiken
+
+#endif  // _MAIKEN_DIST_CODEC_HPP_
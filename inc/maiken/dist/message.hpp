@@ -38,8 +38,6 @@ class Post;
 class Server;
 class ServerSession;
 
-using Sessions = std::unordered_map<std::string, ServerSession>;
-
 class AMessage : public Constants {
   friend class ::cereal::access;
 
@@ -74,7 +72,7 @@ class ARequest : public AMessage {
     ar(::cereal::make_nvp("AMessage", ::cereal::base_class<AMessage>(this)));
   }
 
-  virtual void do_response_for(const kul::http::A1_1Request& req, Sessions& sessions,
+  virtual void do_response_for(const kul::http::A1_1Request& req, ServerSession& session,
                                kul::http::_1_1Response& resp) = 0;
 };
 
@@ -88,7 +86,7 @@ class SetupRequest : public ARequest {
   SetupRequest(std::string const& project, std::string const& settings, kul::cli::Args const& args)
       : m_project_yaml(project), m_settings_yaml(settings), m_args(args) {}
 
-  void do_response_for(const kul::http::A1_1Request& req, Sessions& sessions,
+  void do_response_for(const kul::http::A1_1Request& req, ServerSession& session,
                        kul::http::_1_1Response& resp) override;
 
  private:
@@ -109,6 +107,119 @@ class SetupRequest : public ARequest {
   kul::cli::Args m_args;
 };
 
+// A unit preprocessed by the client for nodes without the project, "cmd" compiles it with the
+//  tokens "in" and OUT_TOKEN standing for the input and object paths on the node
+class PreprocessedUnit {
+ public:
+  static constexpr auto IN_TOKEN = "_MKN_DIST_IN_";
+  static constexpr auto OUT_TOKEN = "_MKN_DIST_OUT_.o";
+  static constexpr uint64_t HASH_SEED = 14695981039346656037ull;
+
+  // FNV-1a, continue a hash by passing the previous result as "hash"
+  static uint64_t HASH(void const* data, size_t const len, uint64_t hash = HASH_SEED) {
+    auto const* bytes = static_cast<uint8_t const*>(data);
+    for (size_t i = 0; i < len; i++) hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash;
+  }
+
+  std::string hash, ext, in, cmd, obj;
+
+  // name of the preprocessed source in a node's store
+  std::string blob() const { return hash + "." + ext; }
+  static bool VALID_BLOB(std::string const& blob) {
+    if (blob.empty() || blob[0] == '.') return false;
+    for (auto const c : blob)
+      if (!std::isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '-') return false;
+    return true;
+  }
+
+  template <class Archive>
+  void serialize(Archive& ar) {
+    ar(hash, ext, in, cmd, obj);
+  }
+};
+
+// Handshake and heartbeat, the node replies with its cores, load and the versions of "m_compilers"
+class StatusRequest : public ARequest {
+  friend class ::cereal::access;
+  friend class RemoteCommandManager;
+  friend class Server;
+
+ public:
+  StatusRequest() {}
+  StatusRequest(std::vector<std::string> const& compilers) : m_compilers(compilers) {}
+
+  void do_response_for(const kul::http::A1_1Request& req, ServerSession& session,
+                       kul::http::_1_1Response& resp) override;
+
+ private:
+  StatusRequest(const StatusRequest&) = delete;
+  StatusRequest(const StatusRequest&&) = delete;
+  StatusRequest& operator=(const StatusRequest&) = delete;
+  StatusRequest& operator=(const StatusRequest&&) = delete;
+
+  template <class Archive>
+  void serialize(Archive& ar) {
+    ar(::cereal::make_nvp("ARequest", ::cereal::base_class<ARequest>(this)));
+    ar(::cereal::make_nvp("m_compilers", m_compilers));
+  }
+
+ private:
+  std::vector<std::string> m_compilers;
+};
+
+class ManifestRequest : public ARequest {
+  friend class ::cereal::access;
+  friend class RemoteCommandManager;
+  friend class Server;
+
+ public:
+  ManifestRequest() {}
+  ManifestRequest(std::vector<std::string> const& blobs) : m_blobs(blobs) {}
+
+  // replies with the blobs the node does not have
+  void do_response_for(const kul::http::A1_1Request& req, ServerSession& session,
+                       kul::http::_1_1Response& resp) override;
+
+ private:
+  ManifestRequest(const ManifestRequest&) = delete;
+  ManifestRequest(const ManifestRequest&&) = delete;
+  ManifestRequest& operator=(const ManifestRequest&) = delete;
+  ManifestRequest& operator=(const ManifestRequest&&) = delete;
+
+  template <class Archive>
+  void serialize(Archive& ar) {
+    ar(::cereal::make_nvp("ARequest", ::cereal::base_class<ARequest>(this)));
+    ar(::cereal::make_nvp("m_blobs", m_blobs));
+  }
+
+ private:
+  std::vector<std::string> m_blobs;
+};
+
+class UploadRequest : public ARequest {
+  friend class ::cereal::access;
+  friend class RemoteCommandManager;
+  friend class Server;
+
+ public:
+  UploadRequest() {}
+  UploadRequest(std::string const& b) { str = b; }
+  void do_response_for(const kul::http::A1_1Request& req, ServerSession& session,
+                       kul::http::_1_1Response& resp) override;
+
+ private:
+  UploadRequest(const UploadRequest&) = delete;
+  UploadRequest(const UploadRequest&&) = delete;
+  UploadRequest& operator=(const UploadRequest&) = delete;
+  UploadRequest& operator=(const UploadRequest&&) = delete;
+
+  template <class Archive>
+  void serialize(Archive& ar) {
+    ar(::cereal::make_nvp("ARequest", ::cereal::base_class<ARequest>(this)));
+  }
+};
+
 class CompileRequest : public ARequest {
   friend class ::cereal::access;
   friend class RemoteCommandManager;
@@ -119,8 +230,9 @@ class CompileRequest : public ARequest {
   CompileRequest(std::string const& directory,
                  const std::vector<std::pair<std::string, std::string>>& src_obj)
       : m_directory(directory), m_src_obj(src_obj) {}
+  CompileRequest(std::vector<PreprocessedUnit> const& units) : m_units(units) {}
 
-  void do_response_for(const kul::http::A1_1Request& req, Sessions& sessions,
+  void do_response_for(const kul::http::A1_1Request& req, ServerSession& session,
                        kul::http::_1_1Response& resp) override;
 
  private:
@@ -134,11 +246,15 @@ class CompileRequest : public ARequest {
     ar(::cereal::make_nvp("ARequest", ::cereal::base_class<ARequest>(this)));
     ar(::cereal::make_nvp("m_src_obj", m_src_obj));
     ar(::cereal::make_nvp("m_directory", m_directory));
+    ar(::cereal::make_nvp("m_units", m_units));
   }
 
+  void compile_preprocessed(ServerSession& session, YAML::Node& root);
+
  private:
   std::string m_directory;
   std::vector<std::pair<std::string, std::string>> m_src_obj;
+  std::vector<PreprocessedUnit> m_units;
 };
 
 class DownloadRequest : public ARequest {
@@ -148,7 +264,7 @@ class DownloadRequest : public ARequest {
 
  public:
   DownloadRequest() {}
-  void do_response_for(const kul::http::A1_1Request& req, Sessions& sessions,
+  void do_response_for(const kul::http::A1_1Request& req, ServerSession& session,
                        kul::http::_1_1Response& resp) override;
 
  private:
@@ -163,6 +279,7 @@ class DownloadRequest : public ARequest {
   }
 };
 
+// "m_file" is rebuilt on the node from "m_chunks" in its store
 class LinkRequest : public ARequest {
   friend class ::cereal::access;
   friend class RemoteCommandManager;
@@ -170,8 +287,9 @@ class LinkRequest : public ARequest {
 
  public:
   LinkRequest() {}
-  LinkRequest(std::string const& b) { str = b; }
-  void do_response_for(const kul::http::A1_1Request& req, Sessions& sessions,
+  LinkRequest(std::string const& file, std::vector<std::string> const& chunks)
+      : m_file(file), m_chunks(chunks) {}
+  void do_response_for(const kul::http::A1_1Request& req, ServerSession& session,
                        kul::http::_1_1Response& resp) override;
 
  private:
@@ -183,24 +301,78 @@ class LinkRequest : public ARequest {
   template <class Archive>
   void serialize(Archive& ar) {
     ar(::cereal::make_nvp("ARequest", ::cereal::base_class<ARequest>(this)));
+    ar(::cereal::make_nvp("m_file", m_file));
+    ar(::cereal::make_nvp("m_chunks", m_chunks));
   }
+
+ private:
+  std::string m_file;
+  std::vector<std::string> m_chunks;
 };
 
+// File data for one message, consecutive "segments" describe consecutive ranges of "c1"
+//  so many small files travel in a single round trip
 class Blob {
  public:
-  bool last_packet = 0;
-  size_t len = 0, files_left = 1;
-  uint8_t* c1 = new uint8_t[BUFF_SIZE];
-  std::string file;
+  struct Segment {
+    std::string file;
+    size_t len = 0;
+    bool last = 0;  // final bytes of "file"
+
+    // serialised size excluding data, used to keep messages within BUFF_SIZE
+    static size_t OVERHEAD(std::string const& file) { return file.size() + 32; }
+
+    template <class Archive>
+    void serialize(Archive& ar) {
+      ar(file, len, last);
+    }
+  };
+
+  bool compressed = 0;
+  size_t len = 0, raw_len = 0, files_left = 1;
+  std::vector<Segment> segments;
+  uint8_t* c1 = BUFFER();
+
   Blob() {}
-  ~Blob() { delete[] c1; }
   template <class Archive>
   void serialize(Archive& ar) {
-    ar(last_packet);
     ar(cereal::make_size_tag(files_left));
+    ar(segments);
+    ar(compressed);
+    ar(cereal::make_size_tag(raw_len));
     ar(cereal::make_size_tag(len));
+    if (len > BUFF_SIZE) KEXCEPT(Exception, "Blob exceeds buffer size");
     ar(cereal::binary_data(c1, sizeof(uint8_t) * len));
-    ar(file);
+  }
+
+  // kept raw if compressing would not make it smaller
+  void compress(uint16_t const level) {
+    if (compressed || !level || !len) return;
+    uint8_t* scratch = SCRATCH();
+    size_t const n = Codec::COMPRESS(level, c1, len, scratch);
+    if (!n) return;
+    std::memcpy(c1, scratch, n);
+    raw_len = len;
+    len = n;
+    compressed = 1;
+  }
+  void decompress() KTHROW(Exception) {
+    if (!compressed) return;
+    if (raw_len > BUFF_SIZE) KEXCEPT(Exception, "Blob exceeds buffer size");
+    Codec::DECOMPRESS(c1, len, SCRATCH(), raw_len);
+    std::memcpy(c1, SCRATCH(), raw_len);
+    len = raw_len;
+    compressed = 0;
+  }
+
+  // one buffer per thread reused by every Blob, only one Blob per thread may be in use
+  static uint8_t* BUFFER() {
+    static thread_local std::unique_ptr<uint8_t[]> buffer(new uint8_t[BUFF_SIZE]);
+    return buffer.get();
+  }
+  static uint8_t* SCRATCH() {
+    static thread_local std::unique_ptr<uint8_t[]> buffer(new uint8_t[BUFF_SIZE]);
+    return buffer.get();
   }
 
  private:
@@ -0,0 +1,152 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef _MAIKEN_DIST_QUEUE_HPP_
+#define _MAIKEN_DIST_QUEUE_HPP_
+
+#include <cstdio>
+#include <deque>
+#include <mutex>
+
+namespace maiken {
+namespace dist {
+
+// Compilation units shared by the local compiler and every remote host, each takes
+//  a batch sized to its capacity when it is free. Units outstanding for much longer
+//  than the average are handed out a second time to whoever asks once nothing is pending.
+//  Every copy handed out is compiled to an object of its own, the first to finish is moved
+//  into place and any later copy is discarded.
+class WorkQueue {
+ public:
+  using Unit = std::pair<maiken::Source, std::string>;
+
+  explicit WorkQueue(std::vector<Unit> const& units) : pending(units.begin(), units.end()) {}
+
+  // units with the objects their copies are compiled to
+  std::vector<Unit> take(size_t const n) {
+    std::lock_guard<std::mutex> lock(mute);
+    std::vector<Unit> batch;
+    uint64_t const now = kul::Now::MILLIS();
+    while (!pending.empty() && batch.size() < n) {
+      auto& f = flight.insert_or_assign(pending.front().second, Flight{pending.front(), now})
+                    .first->second;
+      batch.emplace_back(copy(f));
+      pending.pop_front();
+    }
+    if (!batch.empty()) return batch;
+    for (auto& f : flight) {
+      if (batch.size() == n) break;
+      if (f.second.speculated || now - f.second.start < stale()) continue;
+      f.second.speculated = 1;
+      batch.emplace_back(copy(f.second));
+    }
+    return batch;
+  }
+
+  // the units of "batch" that finished first, with their objects moved into place, copies of
+  //  units already done are removed
+  std::vector<Unit> done(std::vector<Unit> const& batch, uint64_t const& ms)
+      KTHROW(kul::Exception) {
+    std::lock_guard<std::mutex> lock(mute);
+    std::vector<Unit> first;
+    for (auto const& u : batch) {
+      auto it = flight.find(release(u.second));
+      if (it == flight.end()) {
+        std::remove(u.second.c_str());
+        continue;
+      }
+      // a failed compile leaves no object
+      if (std::rename(u.second.c_str(), it->first.c_str()) != 0 && kul::File(u.second))
+        KEXCEPT(Exception, "Failed to move object: ") << u.second;
+      first.emplace_back(it->second.unit);
+      flight.erase(it);
+    }
+    spent += ms;
+    completed += first.size();
+    return first;
+  }
+
+  // units no longer held anywhere else go back to the front of the queue
+  void fail(std::vector<Unit> const& batch) {
+    std::lock_guard<std::mutex> lock(mute);
+    for (auto const& u : batch) {
+      auto it = flight.find(release(u.second));
+      std::remove(u.second.c_str());
+      if (it == flight.end() || --it->second.holders) continue;
+      pending.push_front(it->second.unit);
+      flight.erase(it);
+    }
+  }
+
+  bool finished() {
+    std::lock_guard<std::mutex> lock(mute);
+    return pending.empty() && flight.empty();
+  }
+
+ private:
+  struct Flight {
+    Unit unit;
+    uint64_t start;
+    bool speculated = 0;
+    uint16_t holders = 0, copies = 0;
+  };
+
+  // not an object name, so never linked or archived if left behind
+  Unit copy(Flight& f) {
+    f.holders++;
+    Unit u(f.unit.first, f.unit.second + "." + std::to_string(f.copies++));
+    copies.emplace(u.second, f.unit.second);
+    return u;
+  }
+  // the object of a copy
+  std::string release(std::string const& copy) {
+    auto it = copies.find(copy);
+    if (it == copies.end()) return "";
+    std::string const object(it->second);
+    copies.erase(it);
+    return object;
+  }
+
+  uint64_t stale() const {
+    uint64_t const average = completed ? spent / completed : 0;
+    return (std::max)(uint64_t{5000}, average * 4);
+  }
+
+  std::mutex mute;
+  uint64_t spent = 0, completed = 0;
+  std::deque<Unit> pending;
+  std::unordered_map<std::string, Flight> flight;
+  std::unordered_map<std::string, std::string> copies;  // of units handed out, to their object
+};
+
+}  // end namespace dist
+}  // end namespace maiken
+
+#endif  // _MAIKEN_DIST_QUEUE_HPP_
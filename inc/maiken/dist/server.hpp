@@ -31,38 +31,280 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef _MAIKEN_DIST_SERVER_HPP_
 #define _MAIKEN_DIST_SERVER_HPP_
 
+#include <condition_variable>
+#include <limits>
+#include <set>
+#include <tuple>
+
 namespace maiken {
 namespace dist {
 
 class FileWriter {
  public:
+  // written beside the file as "<file><part>", with "verify" the content must match the hash
+  //  and size the file's name starts with, as given by Store::HASH
+  explicit FileWriter(std::string const& _part = ".part", bool const _verify = 0)
+      : part(_part), verify(_verify) {}
+
+  // data is written beside "file" and moved over it once complete
+  void write(Blob::Segment const& segment, uint8_t const* data) KTHROW(kul::Exception);
+
+  std::string file;
   std::unique_ptr<kul::io::BinaryWriter> bw;
+
+ private:
+  std::string const part;
+  bool const verify;
+  uint64_t hash = PreprocessedUnit::HASH_SEED;
+  size_t len = 0;
+};
+
+// Project loading depends on the process working directory and settings, so a setup runs
+//  alone. Compiles are given their directory and settings, and run at once for different
+//  projects, one at a time for the same project. Waiting sessions are served least recently
+//  served first, a session with many batches cannot hold back one that has just arrived.
+class Scheduler {
+ public:
+  class Turn {
+   public:
+    Turn(Scheduler& s, std::string const& d) : scheduler(s), directory(d) {}
+    ~Turn() { scheduler.release(directory); }
+    Turn(const Turn&) = delete;
+    Turn& operator=(const Turn&) = delete;
+
+   private:
+    Scheduler& scheduler;
+    std::string const directory;
+  };
+
+  // a turn alone, for a setup
+  Turn acquire(std::string const& session) { return acquire(session, ""); }
+  // a turn for compiling the project in "directory"
+  Turn acquire(std::string const& session, std::string const& directory) {
+    std::unique_lock<std::mutex> lock(mute);
+    auto const ticket = std::make_tuple(served[session], arrivals++, session, directory);
+    waiting.insert(ticket);
+    cv.wait(lock, [&] { return ready(ticket); });
+    waiting.erase(ticket);
+    served[session] = ++turns;
+    running.insert(directory);
+    return Turn(*this, directory);
+  }
+
+  // of a session that has gone
+  void forget(std::string const& session) {
+    std::lock_guard<std::mutex> lock(mute);
+    served.erase(session);
+  }
+
+ private:
+  using Ticket = std::tuple<uint64_t, uint64_t, std::string, std::string>;
+
+  // an empty directory is a setup, which excludes every other turn
+  static bool CONFLICT(std::string const& a, std::string const& b) {
+    return a.empty() || b.empty() || a == b;
+  }
+  // nothing running or waiting ahead of "ticket" conflicts with it
+  bool ready(Ticket const& ticket) const {
+    auto const& directory(std::get<3>(ticket));
+    for (auto const& d : running)
+      if (CONFLICT(d, directory)) return false;
+    for (auto it = waiting.begin(); *it != ticket; ++it)
+      if (CONFLICT(std::get<3>(*it), directory)) return false;
+    return true;
+  }
+  void release(std::string const& directory) {
+    {
+      std::lock_guard<std::mutex> lock(mute);
+      running.erase(running.find(directory));
+    }
+    cv.notify_all();
+  }
+
+  uint64_t arrivals = 0, turns = 0;
+  std::mutex mute;
+  std::condition_variable cv;
+  std::unordered_map<std::string, uint64_t> served;
+  std::multiset<std::string> running;
+  std::set<Ticket> waiting;
 };
 
-enum class SessionState : uint16_t { NON = 0, ONE, TWO };
+// Files of a directory shared by every client of the node, removed once unused for long enough
+class IdleFiles {
+ public:
+  explicit IdleFiles(std::string const& dir) : m_dir(dir, 1) {}
+  kul::Dir const& dir() const { return m_dir; }
+
+  // keeps "name" for another "idle" of "evict"
+  void use(std::string const& name) {
+    std::lock_guard<std::mutex> lock(mute);
+    used[name] = kul::Now::MILLIS();
+  }
+  // removes files unused for "idle" milliseconds, those not used since the node started are
+  //  counted from the first call
+  void evict(uint64_t const idle);
+
+ private:
+  kul::Dir const m_dir;
+  std::mutex mute;
+  std::unordered_map<std::string, uint64_t> used;
+};
+
+// Objects compiled from preprocessed units, keyed by the unit's content, the arguments of its
+//  command that compiling reads and the identity of the compiler it names, shared by every
+//  client of the node
+class ObjectCache {
+ public:
+  explicit ObjectCache(kul::Dir const& home) : m_files(home.join("objects")) {}
+
+  // the node's binary of the compiler the unit names, by name on the node's PATH, whatever
+  //  path the client gave
+  static std::string COMPILER(PreprocessedUnit const& unit) KTHROW(Exception);
+  // the unit's command run with COMPILER
+  static std::string COMMAND(PreprocessedUnit const& unit) KTHROW(Exception);
+
+  std::string key(PreprocessedUnit const& unit) const;
+  kul::File file(std::string const& key) const { return kul::File(key + ".o", m_files.dir()); }
+
+  // counts the lookup
+  bool has(std::string const& key) {
+    bool const hit = file(key).is();
+    ++(hit ? hits : misses);
+    if (hit) m_files.use(file(key).name());
+    return hit;
+  }
+  // moves a freshly compiled object into the cache
+  void store(kul::File const& compiled, std::string const& key) KTHROW(kul::Exception) {
+    if (std::rename(compiled.real().c_str(), file(key).full().c_str()) != 0)
+      KEXCEPT(Exception, "Failed to store object: ") << compiled;
+    m_files.use(file(key).name());
+    ++stores;
+  }
+  void evict(uint64_t const idle) { m_files.evict(idle); }
+
+  YAML::Node stats() const;
+
+ private:
+  IdleFiles m_files;
+  std::atomic<uint64_t> hits{0}, misses{0}, stores{0};
+};
+
+// Applications built by SetupRequests, one graph per project directory. A graph is reused while
+//  the project and settings files, the arguments, the SCM revision and the project files of
+//  every dependency it was built from are unchanged. Used only during a setup turn, apart
+//  from "stats" and "release".
+class SetupCache {
+ public:
+  struct Entry {
+    uint64_t key = 0, files = 0;  // of the root, of every project file in the graph
+    std::vector<Application*> apps;
+    kul::hash::set::String projects;  // every project file in the graph
+    std::shared_ptr<AppVars> vars;    // global state left by Application::CREATE
+  };
+
+  static uint64_t KEY(std::string const& directory, std::string const& project,
+                      std::string const& settings, kul::cli::Args const& args);
+
+  // restores the global state of a matching graph
+  Entry const* find(std::string const& directory, uint64_t const key);
+  // replaces any previous graph of "directory"
+  void store(std::string const& directory, uint64_t const key,
+             std::vector<Application*> const& apps);
+  // drops the graph of "directory", and any graph sharing a project with it, so the next setups
+  //  load them again
+  void forget(std::string const& directory);
+
+  // increases with each "forget", sessions note it when they take their applications
+  uint64_t generation() const { return m_generation; }
+  // frees what was forgotten before "oldest", the generation of the oldest session still using
+  //  applications
+  void release(uint64_t const oldest);
+
+  YAML::Node stats() const;
+
+ private:
+  // content of every project file
+  static uint64_t FILES(kul::hash::set::String const& projects);
+
+  // applications and projects that are forgotten, but may still be in use by a session
+  struct Retired {
+    uint64_t generation;
+    std::vector<std::unique_ptr<Application>> apps;
+    std::vector<std::unique_ptr<Project>> projects;
+  };
+
+  mutable std::mutex mute;
+  std::unordered_map<std::string, Entry> m_entries;
+  std::vector<Retired> m_retired;
+  std::atomic<uint64_t> hits{0}, misses{0}, m_generation{0};
+};
 
 class Server;
 class ServerSession {
   friend class Server;
 
  public:
-  ServerSession() : start_time(kul::Now::MILLIS()) {}
+  ServerSession(std::string const& id, Scheduler& scheduler, IdleFiles& store, ObjectCache& cache,
+                SetupCache& setups, kul::Dir const& home)
+      : upload("." + id + ".part", 1),
+        m_id(id),
+        m_scheduler(scheduler),
+        m_store(store),
+        m_cache(cache),
+        m_setups(setups),
+        m_home(home),
+        used(kul::Now::MILLIS()) {}
   void reset_setup(SetupRequest* request) { setup.reset(request); }
   SetupRequest* setup_ptr() { return setup.get(); }
-  void set_apps(const std::vector<Application*>& _apps) { this->apps = std::move(_apps); }
+  // "_apps" and the global application state they were set up with
+  void set_apps(const std::vector<Application*>& _apps) {
+    this->apps = std::move(_apps);
+    vars = std::make_shared<AppVars>(AppVars::INSTANCE());
+    generation = m_setups.generation();
+  }
   std::vector<Application*> apps_vector() { return apps; };
+  std::string const& id() const { return m_id; }
+
+  // exclusive use of the working directory and the global application state
+  Scheduler::Turn setup_turn() { return m_scheduler.acquire(m_id); }
+  // for compiling the project in "directory", which reads "app_vars" and not the global state
+  Scheduler::Turn compile_turn(std::string const& directory) {
+    return m_scheduler.acquire(m_id, directory);
+  }
+  // the global application state this session's applications were set up with
+  AppVars const& app_vars() const { return *vars; }
+
+  // preprocessed sources and binary chunks by content, shared by all sessions
+  IdleFiles& store() { return m_store; }
+  // objects compiled from preprocessed sources for this session only
+  kul::Dir sandbox() const { return kul::Dir(kul::Dir::JOIN(m_home.join("sessions"), m_id), 1); }
+  ObjectCache& cache() { return m_cache; }
+  SetupCache& setups() { return m_setups; }
 
  public:
   std::unique_ptr<kul::io::BinaryReader> binary_reader;
-  std::unique_ptr<kul::io::BinaryWriter> binary_writer;
-  std::vector<std::pair<std::string, std::string>> m_src_obj;
+  // uploads to the shared store, beside their blob under a name of this session's own
+  FileWriter upload;
+  // objects to send back, path here and path on the client
+  std::vector<std::pair<std::string, std::string>> m_downloads;
   kul::hash::set::String objects;
 
  private:
-  uint64_t start_time;
+  std::string const m_id;
+  Scheduler& m_scheduler;
+  IdleFiles& m_store;
+  ObjectCache& m_cache;
+  SetupCache& m_setups;
+  kul::Dir const m_home;
+  // last request and requests in flight, changed under the server's lock apart from releases
+  std::atomic<uint64_t> used;
+  std::atomic<size_t> active{0};
+  // of "setups" when "apps" were set, the maximum while there are none
+  std::atomic<uint64_t> generation{std::numeric_limits<uint64_t>::max()};
+  std::mutex mute;  // requests of one session are handled in order
   std::unique_ptr<SetupRequest> setup = nullptr;
   std::vector<Application*> apps;
-  SessionState state = SessionState::NON;
+  std::shared_ptr<AppVars> vars;
 };
 
 class Server : public kul::http::MultiServer, public Constants {
@@ -70,7 +312,10 @@ class Server : public kul::http::MultiServer, public Constants {
 
  public:
   Server(uint16_t const port, const kul::Dir& _home, uint16_t threads)
-      : kul::http::MultiServer(port, 1, threads), busy(false), m_home(_home) {}
+      : kul::http::MultiServer(port, 1, threads),
+        m_home(_home),
+        store(_home.join("store")),
+        cache(_home) {}
   virtual ~Server() {}
   kul::http::_1_1Response respond(const kul::http::A1_1Request& req) override;
 
@@ -79,25 +324,31 @@ class Server : public kul::http::MultiServer, public Constants {
   Server& operator=(const Server&) = delete;
   Server& operator=(const Server&&) = delete;
 
- protected:
-  void onConnect(char const* cip, uint16_t const& port) override {
-    std::string ip(cip);
-    if (!sessions.count(std::string(ip))) sessions.emplace();
-    ServerSession& sesh = sessions[ip];
-    if (sesh.state != SessionState::NON && sesh.setup == nullptr) {
-      KLOG(ERR) << "Incoming connection has invalid session state - resetting";
-      sessions.erase(ip);
-      onConnect(cip, port);
-    }
-  }
-
  private:
   void operator()();
 
+  // nullptr if the id is not a valid file name, or the session does not exist and "create" is
+  //  false, counts a request in flight until "release"
+  ServerSession* session(std::string const& id, bool create);
+  void release(ServerSession& session) { session.active--; }
+  // drops sessions idle for SESSION_IDLE, with their sandboxes, and every STORE_SWEEP while no
+  //  request is in flight files unused for STORE_IDLE, under "mute"
+  void prune();
+
+  // GET /stats
+  kul::http::_1_1Response stats();
+
  private:
-  std::atomic<bool> busy;
+  static constexpr uint64_t SESSION_IDLE = 1000 * 60 * 60;  // milliseconds
+  static constexpr uint64_t STORE_IDLE = 1000 * 60 * 60 * 24, STORE_SWEEP = 1000 * 60 * 10;
+
   kul::Dir m_home;
-  FileWriter fw;
+  std::mutex mute;
+  uint64_t swept = 0;
+  Scheduler scheduler;
+  IdleFiles store;
+  ObjectCache cache;
+  SetupCache setups;
   std::unordered_map<std::string, ServerSession> sessions;
 };
 }  // end namespace dist
@@ -49,6 +49,12 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define MKN_DEFS_SRC "   src       | Print found source files to std out [allows -d]."
 
 #define MKN_DEFS_TREE "   tree      | Display dependency tree"
+#define MKN_DEFS_COST                                                         \
+  "   cost      | Rank headers by compile time of sources including them, " \
+  "weighted by SCM change count"
+#define MKN_DEFS_MIRROR                                                      \
+  "   mirror    | Copy repositories of resolved dependencies into settings " \
+  "local/mirror"
 
 #define MKN_DEFS_ARG "Arguments:"
 #define MKN_DEFS_ARGS                                                        \
@@ -130,6 +136,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define MKN_DEFS_WARN "   -W/--warn [0-9]        | Add compiler flags for warnings"
 #define MKN_DEFS_WITH "   -w/--with $CSV         | Add profile or dependency from command line"
 #define MKN_DEFS_WITHOUT "   -T/--without $CSV      | Remove dependencies from build"
+#define MKN_DEFS_TTRACE                                                        \
+  "      --time-trace        | Profile each compiled source, report written to " \
+  "./.mkn/log/$PROFILE/time-trace.txt"
 
 #define MKN_DEFS_EXMPL "Examples:"
 #define MKN_DEFS_EXMPL1                                                  \
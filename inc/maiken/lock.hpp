@@ -0,0 +1,83 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef _MAIKEN_LOCK_HPP_
+#define _MAIKEN_LOCK_HPP_
+
+#include <map>
+#include <unordered_map>
+
+#include "kul/os.hpp"
+#include "kul/yaml.hpp"
+
+#include "maiken/defs.hpp"
+
+namespace maiken {
+
+// mkn.lock beside the root project holds the directory, version, commit and profile every
+//  dependency node resolved to. While a node is unchanged and its directory exists setup takes
+//  it from here, without version files or remote lookups. -u and -U resolve everything again and
+//  drop nodes that no longer exist. Paths are written relative to MKN_REPO, MKN_MOD_REPO or the
+//  root project so the file can be committed and shared between machines.
+class LockFile : public Constants {
+ public:
+  struct Entry {
+    std::string project, node, name, version, commit, directory, profile;
+    bool module = 0;
+  };
+
+  static LockFile& INSTANCE() {
+    static LockFile l;
+    return l;
+  }
+
+  void load(const kul::Dir& project, bool const update);
+  // nullptr unless "node" of "project" was resolved before to a directory that still exists
+  Entry const* find(std::string const& project, YAML::Node const& node, bool const module);
+  void add(std::string const& project, YAML::Node const& node, bool const module,
+           std::string const& directory, std::string const& version);
+  // writes the nodes resolved by this run over those loaded, if that changes the file
+  void write() const;
+
+ private:
+  LockFile() {}
+  static std::string KEY(std::string const& project, std::string const& node, bool const module);
+  static std::string EMIT(YAML::Node const& node);
+  // "${MKN_REPO}/name/version" or a path within the root project, otherwise unchanged
+  std::string relative(std::string const& path) const;
+  // inverse of relative, empty if the repository is not configured here
+  std::string absolute(std::string const& path) const;
+
+  std::string file, root;  // empty until loaded
+  std::unordered_map<std::string, Entry> entries;
+  std::map<std::string, Entry> used;
+};
+}  // namespace maiken
+#endif /* _MAIKEN_LOCK_HPP_ */
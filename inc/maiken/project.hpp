@@ -36,6 +36,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "kul/yaml.hpp"
 
 #include "maiken/defs.hpp"
+#include "maiken/validated.hpp"
 
 namespace maiken {
 
@@ -82,7 +83,7 @@ class Projects {
     if (!m_projects.count(f.real())) {
       auto project = std::make_unique<Project>(f);
       try {
-        kul::yaml::Item::VALIDATE(project->root(), project->validator().children());
+        Validated::INSTANCE().validate(*project);
       } catch (const kul::yaml::Exception& e) {
         KEXCEPT(ProjectException, "YAML error encountered in file: " + f.real());
       }
@@ -92,6 +93,22 @@ class Projects {
     }
     return m_projects[f.real()];
   }
+  // the next lookup of "f" loads it again, the existing project is handed to the caller and
+  //  stays valid while it keeps it
+  std::unique_ptr<Project> forget(kul::File const& f) {
+    std::unique_ptr<Project> forgotten;
+    if (m_reloaded.count(f.real())) m_reloaded.erase(f.real());
+    if (!m_projects.count(f.real())) return forgotten;
+    auto const* project = m_projects[f.real()];
+    m_projects.erase(f.real());
+    for (auto it = m_pps.begin(); it != m_pps.end(); ++it)
+      if (it->get() == project) {
+        forgotten = std::move(*it);
+        m_pps.erase(it);
+        break;
+      }
+    return forgotten;
+  }
   void reload(const Project& proj) {
     if (!m_reloaded.count(proj.file())) {
       m_projects[proj.file()]->reload();
@@ -32,11 +32,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define _MAIKEN_PROPERTY_HPP_
 
 namespace maiken {
+// Strings are split at their properties once and the pieces kept for every later string equal
+//  to them. Resolving an application string is remembered by the application.
 class Properties : public Constants {
  private:
-  static std::shared_ptr<std::tuple<std::string, int, int>> KEY(const kul::hash::map::S2S& ps,
-                                                                std::string const& s)
-      KTHROW(kul::Exception);
+  // "a${b}c" as {"a", "b", "c"}, text at even indexes and property names at odd ones
+  using Template = std::vector<std::string>;
+  static std::shared_ptr<Template const> COMPILE(std::string const& s);
+  template <class F>
+  static std::string EXPAND(std::string const& s, F const& value) KTHROW(kul::Exception);
 
  public:
   static std::string RESOLVE(Application const& app, std::string const& s) KTHROW(kul::Exception);
@@ -31,15 +31,31 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef _MAIKEN_REGEX_HPP_
 #define _MAIKEN_REGEX_HPP_
 
+#include <unordered_map>
+
 #include "kul/os.hpp"
 
 namespace maiken {
 
+// Files under a directory are listed once, subdirectories at once, and the listing is used
+//  again while no directory in it has a new mtime. Matches of a pattern are kept with it. The
+//  LISTINGS directories used last are kept.
 class Regexer {
  public:
   static std::vector<std::string> RESOLVE(std::string str) KTHROW(kul::Exception);
 
   static void RESOLVE_REC(std::string const& i, std::vector<std::string>& v) KTHROW(kul::Exception);
+
+ private:
+  struct Listing {
+    std::vector<std::string> files;
+    std::vector<std::pair<std::string, uint64_t>> dirs;
+    std::unordered_map<std::string, std::vector<std::string>> matches;
+  };
+  static constexpr size_t LISTINGS = 16;
+  static bool FRESH(Listing const& l);
+  static void WALK(kul::Dir const& d, Listing& l);
+  static void LIST(kul::Dir const& d, Listing& l);
 };
 }  // end namespace maiken
 
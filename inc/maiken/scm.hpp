@@ -31,12 +31,21 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef _MAIKEN_SCM_HPP_
 #define _MAIKEN_SCM_HPP_
 
+#include <condition_variable>
+#include <mutex>
+
 #include "kul/os.hpp"
 #include "kul/scm/man.hpp"
+#include "kul/threads.hpp"
+
+#include "maiken/defs.hpp"
 
 namespace maiken {
 
-class SCMGetter {
+// Whether remote URLs exist is remembered in ~/maiken/remotes for "remote: ttl" seconds of
+//  settings, candidate URLs for a project are looked up together when one must be. URLs found in
+//  the "local: mirror" of settings are used without looking them up.
+class SCMGetter : public Constants {
  public:
   static SCMGetter& INSTANCE() {
     static SCMGetter s;
@@ -45,12 +54,71 @@ class SCMGetter {
   static bool HAS(const kul::Dir& d);
   static std::string REPO(const kul::Dir& d, std::string const& r, bool module);
   static const kul::SCM* GET(const kul::Dir& d, std::string const& r, bool module);
+  // checks out "version" of "repo" into "d", returns the SCM output. On failure "d" is removed
+  static std::string CO(const kul::SCM* scm, const kul::Dir& d, std::string const& repo,
+                        std::string const& version) KTHROW(kul::scm::Exception);
+  // updates "d" from "repo", returns the SCM output
+  static std::string UP(const kul::SCM* scm, const kul::Dir& d, std::string const& repo,
+                        std::string const& version) KTHROW(kul::scm::Exception);
+  // "repo" as a file name, used for mirrors
+  static std::string NAME(std::string const& repo);
+  // "repo" mirrored under settings local/mirror, if it is
+  static bool MIRRORED(std::string const& repo, std::string const& version = "");
 
  private:
+  SCMGetter();
   static bool IS_SOLID(std::string const& r);
+  static bool LS_REMOTE(std::string const& repo);
   static const kul::SCM* GET_SCM(const kul::Dir& d, std::string const& r, bool module);
+  static std::string CLONE(const kul::SCM* scm, const kul::Dir& d, std::string const& repo,
+                           std::string const& version) KTHROW(kul::Exception);
+
+  // first of "repos" that exists, empty if none
+  std::string lookup(std::vector<std::string> const& repos);
+  void write(uint64_t const now, uint64_t const ttl) const;
 
+  kul::File file;
+  std::mutex mute, mirror_mute;
   kul::hash::map::S2S valids;
+  // url to whether it exists and when that was found in seconds
+  std::unordered_map<std::string, std::pair<bool, uint64_t>> lookups;
+};
+
+// Clones missing dependencies and modules on a bounded pool. Once a clone lands the
+//  dependencies it declares with a version are queued too, so the tree is fetched breadth
+//  first while setup, which stays serial, only waits for the directories it reaches.
+class SCMFetcher : public Constants {
+ public:
+  static SCMFetcher& INSTANCE() {
+    static SCMFetcher s;
+    return s;
+  }
+  // queues a clone of "d" unless it exists or is already queued
+  void fetch(const kul::Dir& d, std::string const& scr, std::string const& version, bool module,
+             std::string const& profiles = "");
+  // blocks while "d" is being cloned, true only once for a clone that succeeded here, whose
+  //  output is printed then
+  bool wait(const kul::Dir& d);
+  // blocks until every queued clone is finished
+  void finish();
+
+  // where "version" of the dependency or module "name" is cloned under MKN_REPO or
+  //  MKN_MOD_REPO, empty if that is not set
+  static std::string DIRECTORY(std::string name, std::string version, bool module);
+
+ private:
+  enum class State : uint16_t { QUEUED = 0, CLONED = 1, CLAIMED = 2, FAILED = 3 };
+  SCMFetcher() {}
+  void clone(kul::Dir d, std::string const scr, std::string const version, bool module,
+             std::string const profiles);
+  void discover(const kul::Dir& d, std::string const& profiles);
+
+  size_t running = 0;
+  std::mutex mute;
+  std::condition_variable cv;
+  std::unique_ptr<kul::ChroncurrentThreadPool<>> pool;
+  std::unordered_map<std::string, State> states;
+  std::unordered_map<std::string, std::string> outputs;  // of clones, until they are claimed
 };
 }  // end namespace maiken
 
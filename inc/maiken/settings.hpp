@@ -47,7 +47,9 @@ class SettingsException : public kul::Exception {
 
 class Settings : public kul::yaml::File, public Constants {
  private:
+  std::string mir;
   std::vector<std::string> rrs, rms;
+  uint64_t rttl = 86400;
   std::unique_ptr<Settings> sup;
   kul::hash::map::S2S ps;
 
@@ -63,8 +65,14 @@ class Settings : public kul::yaml::File, public Constants {
   const kul::yaml::Validator validator() const;
   std::vector<std::string> const& remoteModules() const { return rms; }
   std::vector<std::string> const& remoteRepos() const { return rrs; }
+  // seconds a remote lookup is remembered, 0 to always look up
+  uint64_t const& remoteTTL() const { return rttl; }
+  // directory of mirrored repositories and tarballs, empty if none
+  std::string const& mirror() const { return mir; }
   const kul::hash::map::S2S& properties() const { return ps; }
 
+  // parses and validates "file", unless it was validated as it is before
+  static std::unique_ptr<Settings> CREATE(std::string const& file) KTHROW(SettingsException);
   static Settings& INSTANCE() KTHROW(kul::Exit);
   static bool SET(std::string const& s);
   static std::string RESOLVE(std::string const& s) KTHROW(SettingsException);
@@ -0,0 +1,115 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef _MAIKEN_SPAWN_HPP_
+#define _MAIKEN_SPAWN_HPP_
+
+#ifndef _WIN32
+
+#include <sys/types.h>
+
+// children are started in their own directory with posix_spawn_file_actions_addchdir_np
+#if (defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))) || \
+    defined(__APPLE__)
+#define _MKN_SPAWN_CHDIR_
+#endif
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace maiken {
+namespace proc {
+
+struct SpawnResult {
+  int status = -1;  // exit code, 128 + signal if killed, -1 if never started
+  uint64_t ms = 0;   // wall clock from spawn to exit
+  std::string outs, errs, error;
+};
+
+// Runs commands via posix_spawnp with at most "max" children alive at once, without a shell,
+//  multiplexing every child's stdout/stderr on the calling thread with poll.
+//  Unlike one blocking thread per process the limit is not bound by thread count.
+class Spawner {
+ public:
+  using Callback = std::function<void(SpawnResult&)>;
+
+  explicit Spawner(size_t const max) : max(max ? max : 1) {}
+  Spawner(Spawner const&) = delete;
+  Spawner& operator=(Spawner const&) = delete;
+  ~Spawner();
+
+  // "argv" is run as given in "dir", empty is the current directory. "env" entries are
+  //  "KEY=VALUE", empty inherits the current environment
+  void add(std::vector<std::string> const& argv, std::string const& dir,
+           std::vector<std::string> const& env, Callback const& cb);
+
+  // blocks until all added commands have finished, callbacks are invoked on this thread
+  void run();
+
+  // launch nothing further, children already running are waited on
+  void stop() { stopped = 1; }
+
+  // current environment as "KEY=VALUE" entries with "overrides" replacing or adding keys
+  static std::vector<std::string> ENVIRONMENT(
+      std::vector<std::pair<std::string, std::string>> const& overrides);
+
+ private:
+  struct Task {
+    std::vector<std::string> argv;
+    std::string dir;
+    std::vector<std::string> env;
+    Callback cb;
+  };
+  struct Child {
+    pid_t pid = -1;
+    int out = -1, err = -1;
+    std::chrono::steady_clock::time_point start;
+    SpawnResult res;
+    Callback cb;
+  };
+
+  void launch(Task& task);
+  void reap(Child& child, std::string const& error = "");
+  void abort(std::string const& error);
+
+  bool stopped = 0;
+  size_t const max;
+  std::deque<Task> tasks;
+  std::vector<Child> children;
+};
+
+}  // namespace proc
+}  // namespace maiken
+
+#endif  // _WIN32
+#endif /* _MAIKEN_SPAWN_HPP_ */
@@ -0,0 +1,76 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef _MAIKEN_TOOLCHAIN_HPP_
+#define _MAIKEN_TOOLCHAIN_HPP_
+
+#include <mutex>
+#include <unordered_map>
+
+#include "kul/os.hpp"
+
+#include "maiken/defs.hpp"
+
+namespace maiken {
+
+// Resolves toolchain binaries against PATH and remembers them in ~/maiken/toolchain, keyed by
+//  PATH and the settings file, with their versions, keyed by the binary's path. Either is used
+//  while the binary's mtime is unchanged. The cache is written by "write", once work is done.
+class Toolchain : public Constants {
+ public:
+  static Toolchain& INSTANCE() {
+    static Toolchain t;
+    return t;
+  }
+
+  // full path of "bin" as found on "path", empty if not found
+  std::string which(std::string const& bin, std::string const& path);
+
+  // first line of "bin --version", empty if it cannot be run
+  std::string version(std::string const& bin);
+
+  // replaces the cache if anything was found since it was read
+  void write();
+
+ private:
+  Toolchain();
+
+  // of "path" and the settings file
+  std::string const& key(std::string const& path);
+
+  kul::File file;
+  bool dirty = 0;
+  std::mutex mute;
+  kul::hash::map::S2S keys;
+  // binaries by key and name, versions by binary, with the binary's mtime
+  std::unordered_map<std::string, std::pair<std::string, uint64_t>> whiches, versions;
+};
+}  // namespace maiken
+#endif /* _MAIKEN_TOOLCHAIN_HPP_ */
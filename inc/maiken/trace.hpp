@@ -0,0 +1,74 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef _MAIKEN_TRACE_HPP_
+#define _MAIKEN_TRACE_HPP_
+
+#include <mutex>
+
+#include "maiken/app.hpp"
+
+namespace maiken {
+
+// Wall clock milliseconds of the last compilation of each source,
+//  persisted in bin/$PROFILE/.mkn/time across builds
+class CompileTimes {
+ public:
+  CompileTimes(Application const& app);
+
+  void set(std::string const& src, uint64_t const& ms) {
+    std::lock_guard<std::mutex> lock(mute);
+    ts[src] = ms;
+  }
+  kul::hash::map::S2T<uint64_t> const& times() const { return ts; }
+  void write() const;
+
+ private:
+  kul::File file;
+  std::mutex mute;
+  kul::hash::map::S2T<uint64_t> ts;
+};
+
+class TimeTrace {
+ public:
+  // aggregates per source compiler traces into ./.mkn/log/$PROFILE/time-trace.txt
+  static void REPORT(Application const& app, std::vector<CompilationUnit> const& units,
+                     CompileTimes const& times);
+  // removes the gcc -ftime-report table from "errs" and returns it, leaving diagnostics
+  static std::string SPLIT_REPORT(std::string& errs);
+};
+
+class RebuildCost {
+ public:
+  // ranks headers by summed CompileTimes of every source transitively including them
+  static void REPORT(Application const& app);
+};
+}  // namespace maiken
+#endif /* _MAIKEN_TRACE_HPP_ */
@@ -0,0 +1,81 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef _MAIKEN_VALIDATED_HPP_
+#define _MAIKEN_VALIDATED_HPP_
+
+#include <mutex>
+
+#include "kul/os.hpp"
+#include "kul/yaml.hpp"
+
+#include "maiken/defs.hpp"
+
+namespace maiken {
+
+// Project and settings files that passed validation are remembered in ~/maiken/validated by
+//  path, size, mtime and content hash, with a hash of the validator that passed them, and are
+//  not validated again until the validator, size or content changes. The cache is written
+//  once, on exit.
+class Validated : public Constants {
+ public:
+  static Validated& INSTANCE() {
+    static Validated v;
+    return v;
+  }
+
+  ~Validated();
+
+  template <class T>
+  void validate(T const& yaml) KTHROW(kul::yaml::Exception) {
+    // every file of a type is validated the same way
+    static std::string const stamp(STAMP(yaml.validator().children()));
+    kul::File const f(yaml.file());
+    if (known(f, stamp)) return;
+    kul::yaml::Item::VALIDATE(yaml.root(), yaml.validator().children());
+    add(f, stamp);
+  }
+
+ private:
+  Validated();
+  // hash of what "nodes" check
+  static std::string STAMP(std::vector<kul::yaml::NodeValidator> const& nodes);
+  static std::string DESCRIBE(std::vector<kul::yaml::NodeValidator> const& nodes);
+  // content is hashed only if the size is unchanged and the mtime is not
+  bool known(kul::File const& f, std::string const& stamp);
+  void add(kul::File const& f, std::string const& stamp);
+
+  kul::File file;
+  bool dirty = 0;
+  std::mutex mute;
+  kul::hash::map::S2S keys;
+};
+}  // namespace maiken
+#endif /* _MAIKEN_VALIDATED_HPP_ */
@@ -31,6 +31,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "kul/log.hpp"
 #include "kul/signal.hpp"
 #include "maiken.hpp"
+#include "maiken/toolchain.hpp"
 
 int main(int argc, char* argv[]) {
   maiken::PROGRAM = argv[0];
@@ -62,6 +63,8 @@ int main(int argc, char* argv[]) {
     KERR << e.what();
     ret = 1;
   }
+  // before static destruction, which logging may not survive
+  maiken::Toolchain::INSTANCE().write();
   maiken::Applications::INSTANCE().clear();
   return ret;
 }
@@ -39,7 +39,9 @@ int main(int argc, char* argv[]) {
   try {
     using namespace kul::cli;
     kul::Dir d = kul::user::home(kul::Dir::JOIN(maiken::Constants::STR_MAIKEN, "server"));
-    Args args({}, {Arg('d', maiken::Constants::STR_DIR, ArgType::STRING)});
+    Args args({}, {Arg('d', maiken::Constants::STR_DIR, ArgType::STRING),
+                   Arg('p', maiken::Constants::STR_PORT, ArgType::STRING),
+                   Arg('t', maiken::Constants::STR_THREADS, ArgType::STRING)});
     try {
       args.process(argc, argv);
     } catch (const kul::cli::Exception& e) {
@@ -50,7 +52,16 @@ int main(int argc, char* argv[]) {
       if (!d && !d.mk())
         KEXCEPT(kul::Exception, "diretory provided does not exist or cannot be created");
     }
-    maiken::dist::Server serv(8888, d, 3);
+    uint16_t port = 8888, threads = kul::cpu::threads();
+    try {
+      if (args.has(maiken::Constants::STR_PORT))
+        port = kul::String::UINT16(args.get(maiken::Constants::STR_PORT));
+      if (args.has(maiken::Constants::STR_THREADS))
+        threads = kul::String::UINT16(args.get(maiken::Constants::STR_THREADS));
+    } catch (const kul::StringException& e) {
+      KEXIT(1, "-p or -t argument is invalid");
+    }
+    maiken::dist::Server serv(port, d, threads ? threads : 1);
     kul::Thread thread(std::ref(serv));
     sig.intr([&](int16_t) {
       KERR << "Interrupted";
@@ -48,8 +48,8 @@ void maiken::Application::resolveLang() KTHROW(maiken::Exception) {
     std::string maxS;
     kul::hash::map::S2T<size_t> mapS;
     size_t maxI = 0, maxO = 0;
-    for (auto const& ft : srcMM) mapS.insert(ft.first, 0);
-    for (auto const& ft : srcMM) mapS[ft.first] = mapS[ft.first] + ft.second.size();
+    for (auto const& ft : *srcMM) mapS.insert(ft.first, 0);
+    for (auto const& ft : *srcMM) mapS[ft.first] = mapS[ft.first] + ft.second.size();
     for (auto const& s_i : mapS)
       if (s_i.second > maxI) {
         maxI = s_i.second;
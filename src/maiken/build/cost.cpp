@@ -0,0 +1,228 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "maiken.hpp"
+#include "maiken/trace.hpp"
+
+namespace maiken {
+class IncludeScanner {
+ public:
+  IncludeScanner(Application const& app) : project(app.project().dir().real()) {
+    for (auto const& inc : app.includes()) {
+      kul::Dir const d(inc.first);
+      if (d) dirs.emplace_back(d.real());
+    }
+  }
+
+  // headers the compiler listed for "source" in the -MD/-MMD depfile beside "object", those
+  //  outside the project and its include paths are left out as they are when scanning. False
+  //  if there is no depfile
+  bool depfile(kul::File const& object, std::string const& source, kul::hash::set::String& seen) {
+    std::string const name(object.name());
+    kul::File const d(name.substr(0, name.rfind(".")) + ".d", object.dir());
+    if (!d) return false;
+    // the first rule is the object's, any after it are -MP targets for each header
+    std::string rule;
+    {
+      kul::io::Reader r(d);
+      char const* c = 0;
+      while ((c = r.readLine())) {
+        std::string line(c);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        bool const more = !line.empty() && line.back() == '\\';
+        rule += more ? line.substr(0, line.size() - 1) + " " : line;
+        if (!more) break;
+      }
+    }
+    auto const colon = rule.find(": ");
+    if (colon == std::string::npos) return false;
+    // "\ " is a space within a path, "$$" a dollar
+    std::vector<std::string> deps(1);
+    for (size_t i = colon + 2; i < rule.size(); i++) {
+      char const c = rule[i];
+      if ((c == '\\' && i + 1 < rule.size() && rule[i + 1] == ' ') ||
+          (c == '$' && i + 1 < rule.size() && rule[i + 1] == '$'))
+        deps.back() += rule[++i];
+      else if (c == ' ' || c == '\t') {
+        if (!deps.back().empty()) deps.emplace_back();
+      } else
+        deps.back() += c;
+    }
+    for (auto const& dep : deps) {
+      if (dep.empty()) continue;
+      // relative paths are from the project, where the compiler ran
+      bool const absolute = dep[0] == '/' || (dep.size() > 1 && dep[1] == ':');
+      kul::File const h(absolute ? kul::File(dep) : kul::File(dep, project));
+      if (!h) continue;
+      std::string const real(h.real());
+      if (real != source && within(real)) seen.insert(real);
+    }
+    return true;
+  }
+
+  // every header reachable from "file" that resolves within the project include paths
+  void transitive(std::string const& file, kul::hash::set::String& seen) {
+    for (auto const& h : direct(file)) {
+      if (seen.count(h)) continue;
+      seen.insert(h);
+      transitive(h, seen);
+    }
+  }
+
+ private:
+  std::vector<std::string> direct(std::string const& file) {
+    if (cache.count(file)) return cache.at(file);
+    std::vector<std::string> found;
+    kul::File const f(file);
+    kul::io::Reader r(f);
+    char const* c = 0;
+    while ((c = r.readLine())) {
+      std::string line(c);
+      kul::String::TRIM(line);
+      if (line.empty() || line[0] != '#') continue;
+      line = line.substr(1);
+      kul::String::TRIM(line);
+      if (line.compare(0, 7, "include") != 0) continue;
+      line = line.substr(7);
+      kul::String::TRIM(line);
+      if (line.size() < 3 || (line[0] != '"' && line[0] != '<')) continue;
+      auto const end = line.find(line[0] == '"' ? '"' : '>', 1);
+      if (end == std::string::npos) continue;
+      std::string const name(line.substr(1, end - 1));
+      std::string const resolved(resolve(name, line[0] == '"' ? f.dir().real() : ""));
+      if (!resolved.empty()) found.emplace_back(resolved);
+    }
+    cache.insert(file, found);
+    return found;
+  }
+
+  std::string resolve(std::string const& name, std::string const& local) const {
+    if (!local.empty()) {
+      kul::File const f(name, local);
+      if (f) return f.real();
+    }
+    for (auto const& d : dirs) {
+      kul::File const f(name, d);
+      if (f) return f.real();
+    }
+    return "";
+  }
+
+  bool within(std::string const& header) const {
+    auto const under = [&](std::string const& dir) {
+      return header.size() > dir.size() && header.compare(0, dir.size(), dir) == 0 &&
+             (header[dir.size()] == '/' || header[dir.size()] == '\\');
+    };
+    return under(project) || std::any_of(dirs.begin(), dirs.end(), under);
+  }
+
+  std::string const project;
+  std::vector<std::string> dirs;
+  kul::hash::map::S2T<std::vector<std::string>> cache;
+};
+
+class ChangeCounter {
+ public:
+  // commits touching each file in the git history of the project, empty if not a git repo
+  static kul::hash::map::S2T<uint64_t> COUNT(Application const& app) {
+    kul::hash::map::S2T<uint64_t> changes;
+    try {
+      kul::os::PushDir pushd(app.project().dir());
+      kul::Process t("git");
+      kul::ProcessCapture tc(t);
+      t.arg("rev-parse").arg("--show-toplevel").start();
+      auto top(tc.outs());
+      kul::String::TRIM(top);
+      kul::Process g("git");
+      kul::ProcessCapture gc(g);
+      g.arg("log").arg("--format=").arg("--name-only").start();
+      for (auto const& l : kul::String::LINES(gc.outs())) {
+        if (l.empty()) continue;
+        kul::File const f(l, top);
+        if (!f) continue;  // deleted or renamed since
+        try {
+          changes[f.real()]++;
+        } catch (const kul::Exception& e) {
+          KLOG(DBG) << "Skipping change history of " << l << " : " << e.what();
+        }
+      }
+    } catch (const kul::Exception& e) {
+      KLOG(DBG) << "No change history for " << app.project().dir() << " : " << e.what();
+    }
+    return changes;
+  }
+};
+}  // namespace maiken
+
+void maiken::RebuildCost::REPORT(Application const& app) {
+  CompileTimes const times(app);
+  IncludeScanner scanner(app);
+  auto const changes(ChangeCounter::COUNT(app));
+
+  kul::hash::map::S2T<uint64_t> cost, sources;
+  kul::Dir const objects(app.buildDir().join("obj"));
+  auto const map = app.sourceMap();
+  for (auto const& p1 : *map)
+    for (auto const& p2 : p1.second)
+      for (auto const& src : p2.second) {
+        std::string const in(kul::File(src.in()).real());
+        uint64_t const ms = times.times().count(in) ? times.times().at(in) : 0;
+        kul::hash::set::String headers;
+        if (!scanner.depfile(kul::File(src.object(), objects), in, headers))
+          scanner.transitive(in, headers);
+        for (auto const& h : headers) {
+          cost[h] += ms;
+          sources[h]++;
+        }
+      }
+
+  struct Row {
+    std::string header;
+    uint64_t ms, srcs, commits;
+  };
+  std::vector<Row> rows;
+  for (auto const& c : cost)
+    rows.push_back(
+        {c.first, c.second, sources[c.first], changes.count(c.first) ? changes.at(c.first) : 0});
+  // weight by how often a header changes, headers without history rank by raw cost
+  std::sort(rows.begin(), rows.end(), [](Row const& a, Row const& b) {
+    return a.ms * (a.commits ? a.commits : 1) > b.ms * (b.commits ? b.commits : 1);
+  });
+
+  std::stringstream ss;
+  ss << MKN_PROJECT << ": " << app.project().dir().path();
+  if (app.profile().size() > 0) ss << " [" << app.profile() << "]";
+  KOUT(NON) << ss.str();
+  if (times.times().empty())
+    KOUT(NON) << "No compile times recorded, build first to populate bin/$PROFILE/.mkn/time";
+  KOUT(NON) << "COST(ms)\tSOURCES\tCOMMITS\tHEADER";
+  for (auto const& r : rows)
+    KOUT(NON) << r.ms << "\t" << r.srcs << "\t" << r.commits << "\t" << r.header;
+}
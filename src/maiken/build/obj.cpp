@@ -31,7 +31,12 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "maiken.hpp"
 #include "maiken/dist.hpp"
 #include "maiken/source.hpp"
+#include "maiken/spawn.hpp"
+#include "maiken/trace.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <mutex>
 
 namespace maiken {
@@ -67,169 +72,365 @@ class CompilerPrinter {
     if (!AppVars::INSTANCE().envVars().count("MKN_OBJ")) KEXCEPTION("INTERNAL BADNESS ERROR!");
   }
 };
+
+// Compiles units on this machine for the whole of a build, so times and traces are recorded
+//  once however the units arrive
+class LocalCompiler : public Constants {
+ public:
+  using Unit = std::pair<maiken::Source, std::string>;
+
+  LocalCompiler(Application& app, AppVars const& vars);
+
+  // compiles "units" at once, on the spawner where every compiler allows it
+  void compile(std::vector<Unit> const& units) KTHROW(kul::Exception);
+#if defined(_MKN_WITH_MKN_RAM_) && defined(_MKN_WITH_IO_CEREAL_)
+  // takes units from "work" on every local thread until it is finished
+  void compile(dist::WorkQueue& work) KTHROW(kul::Exception);
+#endif  //  _MKN_WITH_MKN_RAM_) && defined(_MKN_WITH_IO_CEREAL_)
+  // reports failures, writes times and adds what was compiled to "objects"
+  void finish(kul::hash::set::String& objects, std::vector<kul::File>& cacheFiles)
+      KTHROW(kul::Exception);
+
+ private:
+  // "c_unit" compiled "u", which is the object of the build
+  CompilationUnit const& unit(Unit const& u, CompilationUnit const& c_unit);
+  void handle(CompilationUnit const& c_unit, CompilerProcessCapture const& cpc,
+              uint64_t const& ms);
+  void stop();
+
+  Application& app;
+  AppVars const& vars;
+  ThreadingCompiler tc;
+  CompileTimes times;
+  bool const trace;
+  kul::Dir cmdLogDir, outLogDir, errLogDir;
+  std::atomic<bool> failed{0}, stopped{0};
+  std::mutex mute;
+  std::vector<CompilerProcessCapture> cpcs;
+  // references to units are held while they compile
+  std::deque<CompilationUnit> c_units;
+  std::vector<Unit> compiled;
+#ifndef _WIN32
+  std::unique_ptr<proc::Spawner> spawner;
+#endif  // _WIN32
+};
 }  // namespace maiken
 
 void maiken::Application::compile(kul::hash::set::String& objects) KTHROW(kul::Exception) {
-  auto sources = sourceMap();
+  auto const sources = sourceMap();
 
   showConfig();
   CompilerPrinter::print_for(*this);
 
   SourceFinder s_finder(*this);
-  CompilerValidation::check_compiler_for(*this, sources);
+  CompilerValidation::check_compiler_for(*this, *sources);
   std::vector<kul::File> cacheFiles;
-  auto src_objs = s_finder.all_sources_from(sources, objects, cacheFiles);
+  auto src_objs = s_finder.all_sources_from(*sources, objects, cacheFiles);
 
   compile(src_objs, objects, cacheFiles);
 }
 
 void maiken::Application::compile(std::vector<std::pair<maiken::Source, std::string>>& src_objs,
                                   kul::hash::set::String& objects,
-                                  std::vector<kul::File>& cacheFiles) KTHROW(kul::Exception) {
+                                  std::vector<kul::File>& cacheFiles, AppVars const& vars)
+    KTHROW(kul::Exception) {
 #if defined(_MKN_WITH_MKN_RAM_) && defined(_MKN_WITH_IO_CEREAL_)
-  std::vector<std::shared_ptr<maiken::dist::Post>> posts;
   auto compile_lambda = [](std::shared_ptr<maiken::dist::Post> post, const dist::Host& host) {
     post->send(host);
+    {
+      YAML::Node const reply = YAML::Load(post->body());
+      if (reply["status"] && reply["status"].Scalar() != "0")
+        KEXCEPT(dist::Exception, "Remote compilation failed: ")
+            << (reply["message"] ? reply["message"].Scalar() : host.host());
+    }
     dist::FileWriter fw;
     dist::Blob b;
+    auto dowd = std::make_shared<maiken::dist::Post>(
+        maiken::dist::RemoteCommandManager::INST().build_download_request());
     do {
-      auto dowd = std::make_shared<maiken::dist::Post>(
-          maiken::dist::RemoteCommandManager::INST().build_download_request());
       dowd->send(host);
-      std::string body(std::move(dowd->body()));
-      std::istringstream iss(body);
       {
+        std::istringstream iss(dowd->body());
         cereal::PortableBinaryInputArchive iarchive(iss);
         iarchive(b);
       }
-      if (!b.file.empty()) {
-        if (!fw.bw) {
-          kul::File obj(b.file);
-          if (obj) obj = kul::File(std::string(b.file + ".new"));
-          fw.bw = std::make_unique<kul::io::BinaryWriter>(obj);
-        }
-        fw.bw->write(b.c1, b.len);
+      b.decompress();
+      // segments are written from the blob's buffer, they must cover it exactly
+      size_t total = 0;
+      for (auto const& segment : b.segments) {
+        if (segment.len > b.len - total)
+          KEXCEPT(dist::Exception, "Download segments exceed blob from: ") << host.host();
+        total += segment.len;
+      }
+      if (total != b.len)
+        KEXCEPT(dist::Exception, "Download segments do not match blob from: ") << host.host();
+      size_t offset = 0;
+      for (auto const& segment : b.segments) {
+        fw.write(segment, b.c1 + offset);
+        offset += segment.len;
       }
-      if (b.last_packet) fw.bw.reset();
     } while (b.files_left > 0);
   };
   size_t threads = 0;
 
   auto& hosts(maiken::dist::RemoteCommandManager::INST().hosts());
-  if (AppVars::INSTANCE().nodes()) {
-    threads =
-        (hosts.size() < AppVars::INSTANCE().nodes()) ? hosts.size() : AppVars::INSTANCE().nodes();
+  if (vars.nodes()) {
+    threads = (hosts.size() < vars.nodes()) ? hosts.size() : vars.nodes();
   }
   kul::ChroncurrentThreadPool<> ctp(threads, 1, 1000000000, 1000);
   auto compile_ex = [&](kul::Exception const& e) {
     ctp.stop().interrupt();
     throw e;
   };
-  {
-    size_t sources = src_objs.size();
-    size_t divisor = std::floor(sources / (threads + 1));
-    for (size_t i = 0; i < threads; i++) {
-      std::vector<std::pair<std::string, std::string>> remote_src_objs;
-      for (size_t k = 0; k < divisor; k++) {
-        remote_src_objs.push_back(src_objs[0]);
-        src_objs.erase(src_objs.begin());
-      }
-
-      if (!remote_src_objs.empty()) {
-        posts.emplace_back(std::make_shared<maiken::dist::Post>(
-            maiken::dist::RemoteCommandManager::INST().build_compile_request(
-                this->project().dir().real(), remote_src_objs)));
-        ctp.async(std::bind(compile_lambda, posts[i], std::ref(hosts[i])), compile_ex);
-      }
-    }
-  }
-
 #endif  //  _MKN_WITH_MKN_RAM_) && defined(_MKN_WITH_IO_CEREAL_)
-  std::queue<std::pair<maiken::Source, std::string>> sourceQueue;
+
   for (auto& so : src_objs) {
-    sourceQueue.emplace(so.first, so.second);
     kul::File object_file(so.second);
     if (!object_file.dir()) object_file.dir().mk();
   }
-  if (!src_objs.empty()) compile(sourceQueue, objects, cacheFiles);
+  LocalCompiler local(*this, vars);
+
+  bool distributed = 0;
 #if defined(_MKN_WITH_MKN_RAM_) && defined(_MKN_WITH_IO_CEREAL_)
-  ctp.finish(50000000);  // 50 milliseconds
-  ctp.rethrow();
+  if (threads && !src_objs.empty()) {
+    distributed = 1;
+    dist::WorkQueue work(src_objs);
+    dist::NodeMonitor monitor(hosts, threads);
+    auto remote = [&](dist::Host const& host) {
+      if (host.excluded()) return;
+      while (!work.finished()) {
+        if (!host.alive()) {
+          kul::this_thread::nSleep(10000000);  // 10 milliseconds
+          continue;
+        }
+        auto batch = work.take(host.threads());
+        if (batch.empty()) {
+          kul::this_thread::nSleep(10000000);  // 10 milliseconds
+          continue;
+        }
+        auto const start = kul::Now::MILLIS();
+        try {
+          auto& rcm(maiken::dist::RemoteCommandManager::INST());
+          std::vector<dist::PreprocessedUnit> units;
+          if (host.preprocess()) units = dist::Preprocessor::PREPARE(*this, host, batch);
+          std::shared_ptr<maiken::dist::Post> post;
+          if (!units.empty()) {
+            post = std::make_shared<maiken::dist::Post>(rcm.build_compile_request(units));
+          } else {
+            std::vector<std::pair<std::string, std::string>> remote_src_objs;
+            for (auto const& so : batch) remote_src_objs.emplace_back(so.first.in(), so.second);
+            post = std::make_shared<maiken::dist::Post>(
+                rcm.build_compile_request(this->project().dir().real(), remote_src_objs));
+          }
+          compile_lambda(post, host);
+          work.done(batch, kul::Now::MILLIS() - start);
+        } catch (kul::Exception const& e) {
+          KERR << "Node " << host.host() << " failed, returning work to queue: " << e.what();
+          host.alive(0);
+          work.fail(batch);
+        }
+      }
+    };
+    for (size_t i = 0; i < threads; i++)
+      ctp.async(std::bind(remote, std::ref(hosts[i])), compile_ex);
+
+    try {
+      local.compile(work);
+      local.finish(objects, cacheFiles);
+    } catch (...) {
+      ctp.stop().interrupt();
+      throw;
+    }
+    // a node that went down may never answer its last request, its units are done elsewhere
+    bool down = 0;
+    for (size_t i = 0; i < threads; i++) down |= !hosts[i].excluded() && !hosts[i].alive();
+    if (down) {
+      ctp.stop().interrupt();
+    } else {
+      ctp.finish(50000000);  // 50 milliseconds
+      ctp.rethrow();
+    }
+  }
 #endif  //  _MKN_WITH_MKN_RAM_) && defined(_MKN_WITH_IO_CEREAL_)
+  if (!distributed && !src_objs.empty()) {
+    local.compile(src_objs);
+    local.finish(objects, cacheFiles);
+  }
 
   if (_MKN_TIMESTAMPS_) writeTimeStamps(objects, cacheFiles);
 }
 
-void maiken::Application::compile(std::queue<std::pair<maiken::Source, std::string>>& sourceQueue,
-                                  kul::hash::set::String& objects,
-                                  std::vector<kul::File>& cacheFiles) KTHROW(kul::Exception) {
-  ThreadingCompiler tc(*this);
-  kul::ChroncurrentThreadPool<> ctp(AppVars::INSTANCE().threads(), 1, 1000000000, 1000);
-  std::vector<maiken::CompilationUnit> c_units;
-  std::queue<std::pair<maiken::Source, std::string>> cQueue;
-
-  while (sourceQueue.size() > 0) {
-    cQueue.push(sourceQueue.front());
-    c_units.emplace_back(tc.compilationUnit(sourceQueue.front()));
-    sourceQueue.pop();
-  }
-
-  auto o = [](std::string const& s) {
-    if (s.size()) KOUT(NON) << s;
-  };
-  auto e = [](std::string const& s) {
-    if (s.size()) KERR << s;
-  };
+maiken::LocalCompiler::LocalCompiler(Application& app, AppVars const& vars)
+    : app(app),
+      vars(vars),
+      tc(app, vars),
+      times(app),
+      trace(vars.timeTrace() && !vars.dryRun()),
+      cmdLogDir(app.project().dir().join(".mkn/log/" + app.buildDir().name() + "/obj/cmd"), 1),
+      outLogDir(app.project().dir().join(".mkn/log/" + app.buildDir().name() + "/obj/out"), 1),
+      errLogDir(app.project().dir().join(".mkn/log/" + app.buildDir().name() + "/obj/err"), 1) {}
+
+void maiken::LocalCompiler::stop() {
+  stopped = 1;
+#ifndef _WIN32
+  if (spawner) spawner->stop();
+#endif  // _WIN32
+}
 
-  std::mutex mute;
-  std::vector<CompilerProcessCapture> cpcs;
+maiken::CompilationUnit const& maiken::LocalCompiler::unit(Unit const& u,
+                                                           CompilationUnit const& c_unit) {
+  std::lock_guard<std::mutex> lock(mute);
+  compiled.emplace_back(u);
+  c_units.emplace_back(c_unit);
+  return c_units.back();
+}
 
-  auto lambex = [&](kul::Exception const&) {
-    ctp.stop();
-    ctp.interrupt();
-  };
+void maiken::LocalCompiler::handle(maiken::CompilationUnit const& c_unit,
+                                   CompilerProcessCapture const& cpc, uint64_t const& ms) {
+  if (!vars.dryRun()) times.set(kul::File(c_unit.in).real(), ms);
+  std::string errs(cpc.errs());
+  // the report goes to its own file, only diagnostics are shown and logged
+  if (trace && c_unit.comp->timeTraceType() == compiler::TimeTrace_Type::REPORT) {
+    kul::File const obj(c_unit.out);
+    kul::io::Writer(kul::File(obj.name().substr(0, obj.name().rfind(".")) + ".time-report",
+                              obj.dir()))
+        << TimeTrace::SPLIT_REPORT(errs);
+  }
+  if (!vars.dryRun()) {
+    if (kul::LogMan::INSTANCE().inf() || cpc.exception())
+      if (cpc.outs().size()) KOUT(NON) << cpc.outs();
+    if (kul::LogMan::INSTANCE().inf() || cpc.exception())
+      if (errs.size()) KERR << errs;
+    KOUT(INF) << cpc.cmd();
+  } else
+    KOUT(NON) << cpc.cmd();
+
+  if (vars.dump()) {
+    std::string base = kul::File(cpc.file()).name();
+    kul::io::Writer(kul::File(base + ".txt", cmdLogDir)) << cpc.cmd();
+    if (cpc.outs().size()) kul::io::Writer(kul::File(base + ".txt", outLogDir)) << cpc.outs();
+    if (errs.size()) kul::io::Writer(kul::File(base + ".txt", errLogDir)) << errs;
+  }
 
-  kul::Dir cmdLogDir(".mkn/log/" + buildDir().name() + "/obj/cmd", 1);
-  kul::Dir outLogDir(".mkn/log/" + buildDir().name() + "/obj/out", 1);
-  kul::Dir errLogDir(".mkn/log/" + buildDir().name() + "/obj/err", 1);
+  std::lock_guard<std::mutex> lock(mute);
+  cpcs.push_back(cpc);
 
-  auto lambda = [&, o, e](const maiken::CompilationUnit& c_unit) {
-    CompilerProcessCapture const cpc = c_unit.compile();
-    if (!AppVars::INSTANCE().dryRun()) {
-      if (kul::LogMan::INSTANCE().inf() || cpc.exception()) o(cpc.outs());
-      if (kul::LogMan::INSTANCE().inf() || cpc.exception()) e(cpc.errs());
-      KOUT(INF) << cpc.cmd();
-    } else
-      KOUT(NON) << cpc.cmd();
-
-    if (AppVars::INSTANCE().dump()) {
-      std::string base = kul::File(cpc.file()).name();
-      kul::io::Writer(kul::File(base + ".txt", cmdLogDir)) << cpc.cmd();
-      if (cpc.outs().size()) kul::io::Writer(kul::File(base + ".txt", outLogDir)) << cpc.outs();
-      if (cpc.errs().size()) kul::io::Writer(kul::File(base + ".txt", errLogDir)) << cpc.errs();
-    }
+  try {
+    if (!vars.force())
+      if (cpc.exception()) std::rethrow_exception(cpc.exception());
 
-    std::lock_guard<std::mutex> lock(mute);
-    cpcs.push_back(cpc);
+  } catch (kul::Exception const& e) {
+    stop();
+  } catch (const std::exception& e) {
+    KLOG(ERR) << e.what();
+  }
+}
 
-    try {
-      if (!AppVars::INSTANCE().force())
-        if (cpc.exception()) std::rethrow_exception(cpc.exception());
+void maiken::LocalCompiler::compile(std::vector<Unit> const& units) KTHROW(kul::Exception) {
+  std::vector<maiken::CompilationUnit> batch;
+  for (auto const& u : units) batch.emplace_back(unit(u, tc.compilationUnit(u)));
 
-    } catch (kul::Exception const& e) {
-      lambex(e);
-    } catch (const std::exception& e) {
-      KLOG(ERR) << e.what();
+#ifndef _WIN32
+  {
+    auto spawn(kul::env::GET("MKN_SPAWN"));
+    bool use = !vars.dryRun() && (spawn.empty() || kul::String::BOOL(spawn));
+    for (auto const& c_unit : batch)
+      if (!dynamic_cast<cpp::CCompiler const*>(c_unit.comp)) use = 0;
+#ifndef _MKN_SPAWN_CHDIR_
+    use = 0;  // compilers run in the project directory
+#endif  // _MKN_SPAWN_CHDIR_
+    if (use) spawner = std::make_unique<proc::Spawner>(vars.threads());
+  }
+  if (spawner) {
+    std::vector<std::pair<std::string, std::string>> overrides;
+    for (auto const& ev : app.envVars()) overrides.emplace_back(ev.name(), ev.toString());
+    auto const env(proc::Spawner::ENVIRONMENT(overrides));
+    std::string const dir(app.project().dir().real());
+    for (auto const& c_unit : batch) {
+      std::string const cmd(c_unit.compileString());
+      // split as on the command line, nothing is left to a shell
+      spawner->add(kul::cli::asArgs(cmd), dir, env, [&, c_unit, cmd](proc::SpawnResult& r) {
+        CompilerProcessCapture cpc;
+        cpc.capture(r.outs, r.errs);
+        cpc.file(c_unit.out);
+        cpc.cmd(cmd);
+        if (r.status != 0) {
+          std::stringstream ss;
+          if (r.error.empty())
+            ss << "Process exit code: " << r.status;
+          else
+            ss << r.error;
+          cpc.exception(std::make_exception_ptr(kul::Exception(__FILE__, __LINE__, ss.str())));
+        }
+        handle(c_unit, cpc, r.ms);
+      });
     }
-  };
+    spawner->run();
+    spawner.reset();
+    return;
+  }
+#endif  // _WIN32
 
-  for (auto const& unit : c_units) {
+  kul::ChroncurrentThreadPool<> ctp(vars.threads(), 1, 1000000000, 1000);
+  auto lambex = [&](kul::Exception const&) {
+    failed = 1;
+    ctp.stop();
+    ctp.interrupt();
+  };
+  for (auto const& c_unit : batch) {
     kul::this_thread::nSleep(5000000);  // dup appears to be overloaded with too many threads
-    ctp.async(std::bind(lambda, unit), std::bind(lambex, std::placeholders::_1));
+    ctp.async(
+        [this, c_unit, &ctp]() {
+          if (stopped) return;
+          auto const start = std::chrono::steady_clock::now();
+          CompilerProcessCapture const cpc = c_unit.compile();
+          handle(c_unit, cpc,
+                 std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count());
+          if (stopped) ctp.stop();
+        },
+        lambex);
   }
-
   ctp.finish(1000000 * 1000);
+}
 
+#if defined(_MKN_WITH_MKN_RAM_) && defined(_MKN_WITH_IO_CEREAL_)
+// every local thread takes one unit at a time while the remote hosts take theirs, there is
+//  no barrier until the queue is finished
+void maiken::LocalCompiler::compile(dist::WorkQueue& work) KTHROW(kul::Exception) {
+  size_t const threads = vars.threads();
+  kul::ChroncurrentThreadPool<> ctp(threads, 1, 1000000000, 1000);
+  auto lambex = [&](kul::Exception const&) {
+    failed = 1;
+    stopped = 1;
+  };
+  for (size_t i = 0; i < threads; i++)
+    ctp.async(
+        [this, &work]() {
+          while (!stopped && !work.finished()) {
+            auto batch = work.take(1);
+            if (batch.empty()) {
+              kul::this_thread::nSleep(10000000);  // 10 milliseconds
+              continue;
+            }
+            auto const start = kul::Now::MILLIS();
+            auto const c_unit(tc.compilationUnit(batch[0]));
+            auto const cpc = c_unit.compile();
+            auto const ms = kul::Now::MILLIS() - start;
+            // a copy that finished elsewhere first has been reported already
+            auto const first = work.done(batch, ms);
+            if (!first.empty()) handle(unit(first[0], c_unit), cpc, ms);
+          }
+        },
+        lambex);
+  ctp.finish(10000000);  // 10 milliseconds
+  ctp.rethrow();
+}
+#endif  //  _MKN_WITH_MKN_RAM_) && defined(_MKN_WITH_IO_CEREAL_)
+
+void maiken::LocalCompiler::finish(kul::hash::set::String& objects,
+                                   std::vector<kul::File>& cacheFiles) KTHROW(kul::Exception) {
   auto delEmpty = [](auto& dir) {
     if (dir.files().empty()) dir.rm();
   };
@@ -238,20 +439,23 @@ void maiken::Application::compile(std::queue<std::pair<maiken::Source, std::stri
   delEmpty(outLogDir);
   delEmpty(errLogDir);
 
-  if (!AppVars::INSTANCE().force())
-    if (ctp.exception()) KEXIT(1, "Compile error detected");
+  if (!vars.force())
+    if (failed) KEXIT(1, "Compile error detected");
 
-  if (!AppVars::INSTANCE().force())
+  if (!vars.force())
     for (auto& cpc : cpcs)
       if (cpc.exception()) std::rethrow_exception(cpc.exception());
 
-  kul::Dir tmpD(buildDir().join("tmp"), 1);
-  while (cQueue.size()) {
-    kul::Dir dir(kul::File(cQueue.front().second).dir());
+  if (!vars.dryRun()) times.write();
+  if (trace) TimeTrace::REPORT(app, std::vector<CompilationUnit>(c_units.begin(), c_units.end()),
+                               times);
+
+  kul::Dir tmpD(app.buildDir().join("tmp"), 1);
+  for (auto const& u : compiled) {
+    kul::Dir dir(kul::File(u.second).dir());
     if (dir.real() != tmpD.real()) {
-      objects.insert(cQueue.front().second);
-      cacheFiles.emplace_back(kul::File(cQueue.front().first.in()));
+      objects.insert(u.second);
+      cacheFiles.emplace_back(kul::File(u.first.in()));
     }
-    cQueue.pop();
   }
 }
@@ -0,0 +1,306 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <cctype>
+#include <fstream>
+
+#include "maiken.hpp"
+#include "maiken/trace.hpp"
+
+maiken::CompileTimes::CompileTimes(Application const& app)
+    : file("time", app.buildDir().join(".mkn")) {
+  if (!file) return;
+  kul::io::Reader r(file);
+  char const* c = 0;
+  while ((c = r.readLine())) {
+    std::string s(c);
+    auto pos = s.find(" ");
+    if (pos == std::string::npos) continue;
+    try {
+      ts.insert(s.substr(pos + 1), kul::String::UINT64(s.substr(0, pos)));
+    } catch (const kul::StringException& e) {
+      KLOG(DBG) << "Ignoring invalid compile time: " << s;
+    }
+  }
+}
+
+void maiken::CompileTimes::write() const {
+  if (!file.dir()) file.dir().mk();
+  kul::io::Writer w(file);
+  for (auto const& t : ts) w << t.second << " " << t.first << kul::os::EOL();
+}
+
+namespace maiken {
+// Reads the "traceEvents" of a chrome trace as it goes, only the name, duration and detail of
+//  each event are kept, traces of large units run to many megabytes
+class TraceEvents {
+ public:
+  struct Event {
+    std::string name, detail;
+    uint64_t dur = 0;
+  };
+
+  explicit TraceEvents(std::istream& _in) : in(_in) {}
+
+  // false once the events are done
+  bool next(Event& e) KTHROW(kul::Exception) {
+    if (done) return false;
+    if (!started) {
+      started = 1;
+      expect('{');
+      while (1) {
+        if (!key()) return end();
+        if (is("traceEvents")) break;
+        skip();
+      }
+      expect('[');
+      if (peek() == ']') return end();
+    } else {
+      char const c = get();
+      if (c == ']') return end();
+      if (c != ',') KEXCEPTION("Invalid trace");
+    }
+    e = Event{};
+    expect('{');
+    while (key()) {
+      if (is("name"))
+        e.name = string();
+      else if (is("dur"))
+        e.dur = kul::String::UINT64(token());
+      else if (is("args")) {
+        expect('{');
+        while (key())
+          if (is("detail"))
+            e.detail = string();
+          else
+            skip();
+      } else
+        skip();
+    }
+    return true;
+  }
+
+ private:
+  char peek() {
+    while (std::isspace(in.peek())) in.get();
+    if (in.peek() == std::char_traits<char>::eof()) KEXCEPTION("Truncated trace");
+    return static_cast<char>(in.peek());
+  }
+  char get() {
+    peek();
+    return static_cast<char>(in.get());
+  }
+  void expect(char const c) {
+    if (get() != c) KEXCEPTION("Invalid trace");
+  }
+  bool end() {
+    done = 1;
+    return false;
+  }
+  // the last key read
+  bool is(char const* s) const { return k == s; }
+  // the next key of an object and its colon, false at the end of the object
+  bool key() {
+    char c = peek();
+    if (c == ',') {
+      get();
+      c = peek();
+    }
+    if (c == '}') {
+      get();
+      return false;
+    }
+    k = string();
+    expect(':');
+    return true;
+  }
+  std::string string() {
+    expect('"');
+    std::string s;
+    for (int c = in.get(); c != '"'; c = in.get()) {
+      if (c == std::char_traits<char>::eof()) KEXCEPTION("Truncated trace");
+      if (c == '\\') {
+        c = in.get();
+        if (c == 'n') c = '\n';
+        else if (c == 't') c = '\t';
+        else if (c == 'u') {
+          for (size_t i = 0; i < 4; i++) in.get();
+          c = '?';
+        }
+      }
+      s += static_cast<char>(c);
+    }
+    return s;
+  }
+  // a number, true, false or null
+  std::string token() {
+    std::string s;
+    peek();
+    while (in.peek() != std::char_traits<char>::eof() &&
+           std::string(",}] \t\r\n").find(static_cast<char>(in.peek())) == std::string::npos)
+      s += static_cast<char>(in.get());
+    return s;
+  }
+  void skip() {
+    char const c = peek();
+    if (c == '"') {
+      string();
+      return;
+    }
+    if (c != '{' && c != '[') {
+      token();
+      return;
+    }
+    size_t depth = 0;
+    do {
+      char const n = peek();
+      if (n == '"') {
+        string();
+        continue;
+      }
+      in.get();
+      if (n == '{' || n == '[') depth++;
+      if (n == '}' || n == ']') depth--;
+    } while (depth);
+  }
+
+  std::istream& in;
+  std::string k;
+  bool started = 0, done = 0;
+};
+
+class TimeTraceReport {
+ public:
+  using Totals = kul::hash::map::S2T<uint64_t>;
+
+  // clang -ftime-trace, microseconds per event, "Source" events are inclusive of nested headers
+  static void CLANG(kul::File const& json, Totals& headers, Totals& templates) {
+    try {
+      std::ifstream in(json.real(), std::ios::binary);
+      if (!in) KEXCEPTION("Cannot open");
+      TraceEvents events(in);
+      TraceEvents::Event e;
+      while (events.next(e)) {
+        if (e.detail.empty() || !e.dur) continue;
+        if (e.name == "Source")
+          add(headers, e.detail, e.dur);
+        else if (e.name == "InstantiateClass" || e.name == "InstantiateFunction")
+          add(templates, e.detail, e.dur);
+      }
+    } catch (const std::exception& e) {
+      KLOG(ERR) << "Failed to read time trace: " << json.real() << " : " << e.what();
+    }
+  }
+
+  // gcc -ftime-report, third column is wall seconds
+  //  " phase parsing          :   0.30 ( 58%)   0.08 ( 62%)   0.38 ( 58%)   17M ( 67%)"
+  static void GCC(std::string const& report, Totals& phases) {
+    for (auto const& line : kul::String::LINES(report)) {
+      auto const pos = line.find(":");
+      if (pos == std::string::npos) continue;
+      std::string name(line.substr(0, pos));
+      kul::String::TRIM(name);
+      if (name.empty() || name == "TOTAL") continue;
+      std::vector<std::string> nums;
+      for (auto const& b : kul::String::SPLIT(line.substr(pos + 1), ' '))
+        if (!b.empty() && b[0] != '(' && b.find("%)") == std::string::npos) nums.push_back(b);
+      if (nums.size() < 3) continue;
+      try {
+        add(phases, name, static_cast<uint64_t>(std::stod(nums[2]) * 1000000));
+      } catch (const std::exception& e) {
+        // not a timing line
+      }
+    }
+  }
+
+  static void add(Totals& totals, std::string const& k, uint64_t const& v) { totals[k] += v; }
+
+  static void print(std::ostream& out, std::string const& title, Totals const& totals,
+                    uint64_t const& divisor, std::string const& unit) {
+    if (totals.empty()) return;
+    std::vector<std::pair<std::string, uint64_t>> sorted(totals.begin(), totals.end());
+    std::sort(sorted.begin(), sorted.end(),
+              [](auto const& a, auto const& b) { return a.second > b.second; });
+    out << title << kul::os::EOL();
+    for (size_t i = 0; i < sorted.size() && i < 25; i++)
+      out << "  " << (sorted[i].second / divisor) << unit << "\t" << sorted[i].first
+          << kul::os::EOL();
+    out << kul::os::EOL();
+  }
+};
+}  // namespace maiken
+
+void maiken::TimeTrace::REPORT(Application const& app, std::vector<CompilationUnit> const& units,
+                               CompileTimes const& times) {
+  TimeTraceReport::Totals tus, headers, templates, phases;
+  for (auto const& unit : units) {
+    std::string const src(kul::File(unit.in).real());
+    if (times.times().count(src)) tus.insert(src, times.times().at(src));
+    kul::File const obj(unit.out);
+    std::string const stem(obj.name().substr(0, obj.name().rfind(".")));
+    kul::File const json(stem + ".json", obj.dir());
+    kul::File const report(stem + ".time-report", obj.dir());
+    auto const type(unit.comp->timeTraceType());
+    if (type == compiler::TimeTrace_Type::JSON && json)
+      TimeTraceReport::CLANG(json, headers, templates);
+    if (type == compiler::TimeTrace_Type::REPORT && report) {
+      std::stringstream ss;
+      kul::io::Reader r(report);
+      char const* c = 0;
+      while ((c = r.readLine())) ss << c << kul::os::EOL();
+      TimeTraceReport::GCC(ss.str(), phases);
+    }
+  }
+  std::stringstream ss;
+  TimeTraceReport::print(ss, "SLOWEST SOURCES", tus, 1, "ms");
+  TimeTraceReport::print(ss, "HEADERS BY TOTAL PARSE TIME", headers, 1000, "ms");
+  TimeTraceReport::print(ss, "TEMPLATE INSTANTIATIONS", templates, 1000, "ms");
+  TimeTraceReport::print(ss, "COMPILER PHASES", phases, 1000, "ms");
+
+  kul::File const out("time-trace.txt",
+                      kul::Dir(app.project().dir().join(".mkn/log/" + app.buildDir().name()), 1));
+  kul::io::Writer(out) << ss.str();
+  KOUT(NON) << "TIME TRACE: " << out.real() << kul::os::EOL() << ss.str();
+}
+
+std::string maiken::TimeTrace::SPLIT_REPORT(std::string& errs) {
+  auto start = errs.find("Time variable");
+  if (start == std::string::npos) return "";
+  start = errs.rfind('\n', start);
+  start = start == std::string::npos ? 0 : start + 1;
+  auto end = errs.find("TOTAL", start);
+  end = end == std::string::npos ? std::string::npos : errs.find('\n', end);
+  end = end == std::string::npos ? errs.size() : end + 1;
+  std::string const report(errs.substr(start, end - start));
+  // the blank line gcc prints before the table goes with it
+  if (start && errs[start - 1] == '\n') start--;
+  errs.erase(start, end - start);
+  return report;
+}
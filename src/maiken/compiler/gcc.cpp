@@ -28,6 +28,8 @@ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
+#include <sys/stat.h>
+
 #include "maiken.hpp"
 
 maiken::cpp::GccCompiler::GccCompiler(int const& v) : CCompiler(v) {
@@ -160,6 +162,8 @@ maiken::CompilerProcessCapture maiken::cpp::GccCompiler::buildLibrary(LinkDAO& d
   auto &linker = dao.linker, &linkerEnd = dao.linkerEnd;
   auto& mode = dao.mode;
 
+  if (mode == compiler::Mode::STAT) return buildArchive(dao);
+
   kul::File out(dao.out);
 
   std::vector<std::string> fobjects;
@@ -170,8 +174,6 @@ maiken::CompilerProcessCapture maiken::cpp::GccCompiler::buildLibrary(LinkDAO& d
   }
 
   std::string lib = out.dir().join(sharedLib(app, out.name()));
-
-  if (mode == compiler::Mode::STAT) lib = out.dir().join(staticLib(out.name()));
   lib = kul::File(lib).esc();
   std::string cmd = linker;
   if (mode == compiler::Mode::SHAR) cmd = LD(linker);
@@ -222,6 +224,143 @@ maiken::CompilerProcessCapture maiken::cpp::GccCompiler::buildLibrary(LinkDAO& d
   return pc;
 }
 
+namespace maiken {
+namespace cpp {
+class ArchiveManifest {
+ public:
+  ArchiveManifest(Application const& app) : file("archive", app.buildDir().join(".mkn")) {
+    if (!file) return;
+    kul::io::Reader r(file);
+    char const* c = r.readLine();
+    if (!c) return;
+    thin = std::string(c) == "thin";
+    while ((c = r.readLine())) {
+      std::string s(c);
+      auto pos = s.rfind(" ");
+      if (pos == std::string::npos) continue;
+      members.insert(s.substr(0, pos), s.substr(pos + 1));
+    }
+    valid = 1;
+  }
+
+  // size and modification time, in nanoseconds where the system has them, an object rebuilt
+  //  within the same second as the member it replaces still differs
+  static std::string STAMP(kul::File const& f) {
+    std::stringstream ss;
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(f.real().c_str(), &st) == 0) ss << st.st_size << ":" << st.st_mtime;
+#else
+    struct stat st;
+    if (stat(f.real().c_str(), &st) == 0) {
+#if defined(__APPLE__)
+      auto const& mtime = st.st_mtimespec;
+#else
+      auto const& mtime = st.st_mtim;
+#endif  // __APPLE__
+      ss << st.st_size << ":" << mtime.tv_sec << "." << mtime.tv_nsec;
+    }
+#endif  // _WIN32
+    return ss.str();
+  }
+
+  void write(kul::hash::map::S2S const& objects, bool const t) {
+    if (!file.dir()) file.dir().mk();
+    kul::io::Writer w(file);
+    w << (t ? "thin" : "full") << kul::os::EOL();
+    for (auto const& o : objects) w << o.first << " " << o.second << kul::os::EOL();
+  }
+
+  bool valid = 0, thin = 0;
+  kul::File file;
+  kul::hash::map::S2S members;  // by STAMP
+};
+}  // namespace cpp
+}  // namespace maiken
+
+maiken::CompilerProcessCapture maiken::cpp::GccCompiler::buildArchive(LinkDAO& dao) const
+    KTHROW(kul::Exception) {
+  auto& app = dao.app;
+  auto& dryRun = dao.dryRun;
+  auto &linker = dao.linker, &linkerEnd = dao.linkerEnd;
+
+  kul::File out(dao.out);
+  kul::File lib(staticLib(out.name()), out.dir());
+
+  auto ar_thin(kul::env::GET("MKN_AR_THIN"));
+  bool const thin = ar_thin.empty() ? 0 : kul::String::BOOL(ar_thin);
+
+  // objects left behind by sources since removed are not members
+  kul::hash::set::String current;
+  {
+    auto const sources = app.sourceMap();
+    for (auto const& ft : *sources)
+      for (auto const& kv : ft.second)
+        for (auto const& s : kv.second) current.insert(s.object());
+  }
+  kul::hash::map::S2S objects;
+  for (auto const& d : dao.stars)
+    for (auto const& f : d.files())
+      if (current.count(f.name())) objects.insert(f.real(), ArchiveManifest::STAMP(f));
+  for (std::string const& o : dao.objects) {
+    kul::File f(o);
+    if (f) objects.insert(f.real(), ArchiveManifest::STAMP(f));
+  }
+
+  // existing members are only trusted if we wrote them, otherwise start from scratch
+  ArchiveManifest manifest(app);
+  bool const full = !lib || !manifest.valid || manifest.thin != thin;
+
+  std::vector<std::string> changed, removed;
+  if (!full) {
+    for (auto const& o : objects)
+      if (!manifest.members.count(o.first) || manifest.members.at(o.first) != o.second)
+        changed.emplace_back(o.first);
+    for (auto const& m : manifest.members)
+      if (!objects.count(m.first)) removed.emplace_back(m.first);
+  }
+
+  std::string cmd = linker;
+  std::vector<std::string> bits;
+  if (linker.find(" ") != std::string::npos) {
+    bits = kul::cli::asArgs(linker);
+    cmd = bits[0];
+  }
+
+  CompilerProcessCapture pc;
+  pc.file(lib.esc());
+  std::stringstream cmds;
+  try {
+    if (!removed.empty()) {
+      kul::Process p(cmd);
+      p.arg("-d").arg(lib.escm());
+      for (auto const& r : removed) p << kul::File(r).escm();
+      cmds << p.toString();
+      if (!dryRun) p.set(app.envVars()).start();
+    }
+    if (full || !changed.empty()) {
+      if (full && lib && !dryRun) lib.rm();
+      kul::Process p(cmd);
+      for (unsigned int i = 1; i < bits.size(); i++) p.arg(bits[i]);
+      if (thin) p.arg("--thin");
+      p.arg(lib.escm());
+      if (full)
+        for (auto const& o : objects) p << kul::File(o.first).escm();
+      else
+        for (auto const& c : changed) p << kul::File(c).escm();
+      for (std::string const& s : kul::cli::asArgs(linkerEnd)) p.arg(s);
+      if (cmds.str().size()) cmds << kul::os::EOL();
+      cmds << p.toString();
+      if (!dryRun) p.set(app.envVars()).start();
+    }
+    if (!dryRun) manifest.write(objects, thin);
+  } catch (const kul::proc::Exception& e) {
+    pc.exception(std::current_exception());
+  }
+  pc.cmd(cmds.str());
+  return pc;
+}
+
 maiken::CompilerProcessCapture maiken::cpp::GccCompiler::compileSource(CompileDAO& dao) const
     KTHROW(kul::Exception) {
   auto& app = dao.app;
@@ -242,18 +381,24 @@ maiken::CompilerProcessCapture maiken::cpp::GccCompiler::compileSource(CompileDA
     bits = kul::cli::asArgs(compiler);
     cmd = bits[0];
   }
-  kul::Process p(cmd);
+  // run from the project without changing the working directory of this process, which
+  //  compiles of other projects share
+  kul::Process p(cmd, app.project().dir().real());
   for (unsigned int i = 1; i < bits.size(); i++) p.arg(bits[i]);
   for (auto const& def : app.defines()) p << std::string("-D" + def);
-  for (std::string const& s : incs) {
-    kul::Dir d(s);
-    if (d)
-      p.arg("-I" + s);
-    else
-      p.arg("-include " + s);
-  }
+  if (dao.includeFiles) {
+    for (std::string const& s : incs) p.arg("-I" + s);
+    for (std::string const& s : *dao.includeFiles) p.arg("-include " + s);
+  } else
+    for (std::string const& s : incs) {
+      kul::Dir d(s);
+      if (d)
+        p.arg("-I" + s);
+      else
+        p.arg("-include " + s);
+    }
   for (std::string const& s : args) p.arg(s);
-  p.arg("-o").arg(out).arg("-c").arg(in);
+  p.arg("-o").arg(out).arg(dao.preprocess ? "-E" : "-c").arg(in);
   CompilerProcessCapture pc;
   if (!kul::LogMan::INSTANCE().inf()) pc.setProcess(p);
   try {
@@ -192,11 +192,15 @@ maiken::CompilerProcessCapture maiken::cpp::WINCompiler::compileSource(CompileDA
     bits = kul::cli::asArgs(compiler);
     cmd = bits[0];
   }
-  kul::Process p(cmd);
+  // run from the project without changing the working directory of this process, which
+  //  compiles of other projects share
+  kul::Process p(cmd, app.project().dir().real());
   for (size_t i = 1; i < bits.size(); i++) p.arg(bits[i]);
   p.arg("-nologo");
   for (auto const& def : app.defines()) p << std::string("-D" + def);
   for (std::string const& s : incs) p.arg("-I\"" + s + "\"");
+  if (dao.includeFiles)
+    for (std::string const& s : *dao.includeFiles) p.arg("-FI\"" + s + "\"");
   for (std::string const& s : args) p.arg(s);
   p.arg("-c").arg("-Fo\"" + out + "\"").arg("\"" + in + "\"");
   CompilerProcessCapture pc;
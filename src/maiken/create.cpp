@@ -30,6 +30,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "maiken.hpp"
 #include "maiken/dist.hpp"
+#include "maiken/lock.hpp"
+#include "maiken/scm.hpp"
+#include "maiken/trace.hpp"
 
 namespace maiken {
 using namespace kul::cli;
@@ -53,6 +56,7 @@ class CLIHandler : public Constants {
         Arg('p', STR_PROFILE, ArgType::STRING), Arg('P', STR_PROPERTY, ArgType::STRING),
         Arg('r', STR_RUN_ARG, ArgType::STRING), Arg('s', STR_SCM_STATUS), Arg('S', STR_SHARED),
         Arg('t', STR_THREADS, ArgType::MAYBE), Arg('T', STR_WITHOUT, ArgType::STRING),
+        Arg(' ', STR_TIME_TRACE),
         Arg('u', STR_SCM_UPDATE), Arg('U', STR_SCM_FUPDATE), Arg('v', STR_VERSION),
         Arg('w', STR_WITH, ArgType::STRING), Arg('W', STR_WARN, ArgType::MAYBE),
         Arg('x', STR_SETTINGS, ArgType::STRING)
@@ -64,7 +68,8 @@ class CLIHandler : public Constants {
                                   Cmd(STR_CLEAN),    Cmd(STR_DEPS),    Cmd(STR_BUILD),
                                   Cmd(STR_RUN),      Cmd(STR_COMPILE), Cmd(STR_LINK),
                                   Cmd(STR_PROFILES), Cmd(STR_DBG),     Cmd(STR_PACK),
-                                  Cmd(STR_INFO),     Cmd(STR_TREE),    Cmd(STR_TEST)};
+                                  Cmd(STR_INFO),     Cmd(STR_TREE),    Cmd(STR_TEST),
+                                  Cmd(STR_COST),     Cmd(STR_MIRROR)};
 
  public:
   std::vector<kul::cli::Arg> args() { return argV; }
@@ -203,6 +208,7 @@ std::vector<maiken::Application*> maiken::Application::CREATE(kul::cli::Args con
 
   if (args.has(STR_DUMP)) AppVars::INSTANCE().dump(true);
   if (args.has(STR_FORCE)) AppVars::INSTANCE().force(true);
+  if (args.has(STR_TIME_TRACE)) AppVars::INSTANCE().timeTrace(true);
   if (args.has(STR_DRY_RUN)) AppVars::INSTANCE().dryRun(true);
   if (args.has(STR_SHARED)) AppVars::INSTANCE().shar(true);
   if (args.has(STR_STATIC)) AppVars::INSTANCE().stat(true);
@@ -297,6 +303,8 @@ std::vector<maiken::Application*> maiken::Application::CREATE(kul::cli::Args con
   }
 
   AppVars::INSTANCE().dependencyString(args.has(STR_DEP) ? args.get(STR_DEP) : "");
+  LockFile::INSTANCE().load(project.dir(),
+                            AppVars::INSTANCE().update() || AppVars::INSTANCE().fupdate());
   std::vector<Application*> apps;
   for (auto profile : profiles) {
     auto* app = Applications::INSTANCE().getOrCreateRoot(project, profile);
@@ -307,6 +315,9 @@ std::vector<maiken::Application*> maiken::Application::CREATE(kul::cli::Args con
     a.buildDepVec(AppVars::INSTANCE().dependencyString());
     a.addCLIArgs(args);
   }
+  // clones queued for profiles that were not set up
+  SCMFetcher::INSTANCE().finish();
+  LockFile::INSTANCE().write();
 
   if (apps.size() == 1) {
     if (args.has(STR_PROFILES)) {
@@ -386,7 +397,8 @@ std::vector<maiken::Application*> maiken::Application::CREATE(kul::cli::Args con
   }
   if (args.has(STR_SRC)) {
     auto print_srcs = [](auto const* a) {
-      for (auto const& p1 : a->sourceMap())
+      auto const sources = a->sourceMap();
+      for (auto const& p1 : *sources)
         for (auto const& p2 : p1.second)
           for (auto const& p3 : p2.second) KOUT(NON) << kul::File(p3.in()).full();
     };
@@ -400,13 +412,24 @@ std::vector<maiken::Application*> maiken::Application::CREATE(kul::cli::Args con
     for (auto a : apps) a->scmStatus(args.has(STR_DEP));
     KEXIT(0, "");
   }
+  if (args.has(STR_COST)) {
+    for (auto a : apps) RebuildCost::REPORT(*a);
+    KEXIT(0, "");
+  }
+  if (args.has(STR_MIRROR)) {
+    Application::SCM_MIRROR(apps);
+    KEXIT(0, "");
+  }
 
   if (apps.size() == 1) {
     if (args.has(STR_ADD))
       for (auto const& s : kul::String::ESC_SPLIT(args.get(STR_ADD), ','))
         apps[0]->addSourceLine(s);
 
-    if (args.has(STR_MAIN)) apps[0]->main_ = Source(args.get(STR_MAIN));
+    if (args.has(STR_MAIN)) {
+      apps[0]->main_ = Source(args.get(STR_MAIN));
+      apps[0]->forgetSourceMap();
+    }
     if (args.has(STR_OUT)) apps[0]->out = args.get(STR_OUT);
   }
 
@@ -417,11 +440,21 @@ std::vector<maiken::Application*> maiken::Application::CREATE(kul::cli::Args con
     if (hosts.empty()) KEXCEPTION("Settings file has no hosts configured");
     size_t threads =
         (hosts.size() < AppVars::INSTANCE().nodes()) ? hosts.size() : AppVars::INSTANCE().nodes();
-    // ping nodes and set active
+    // unreachable or mismatched nodes are left out rather than failing the build
     auto ping = [&](const maiken::dist::Host& host) {
-      auto post = std::make_unique<maiken::dist::Post>(
-          maiken::dist::RemoteCommandManager::INST().build_setup_query(*apps[0], args));
-      post->send(host);
+      if (!maiken::dist::NodeMonitor::HANDSHAKE(*apps[0], host)) return host.exclude();
+      try {
+        auto post = std::make_unique<maiken::dist::Post>(
+            maiken::dist::RemoteCommandManager::INST().build_setup_query(*apps[0], args));
+        post->send(host);
+        YAML::Node const reply = YAML::Load(post->body());
+        if (!reply["status"] || reply["status"].Scalar() != "0")
+          KEXCEPT(maiken::dist::Exception, "Node rejected setup: ")
+              << (reply["message"] ? reply["message"].Scalar() : post->body());
+      } catch (std::exception const& e) {
+        KERR << "Node " << host.host() << " setup failed, node unused: " << e.what();
+        host.exclude();
+      }
     };
     kul::ChroncurrentThreadPool<> ctp(threads, 1, 1000000000, 1000);
     std::exception_ptr exp;
@@ -29,33 +29,50 @@ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "maiken/github.hpp"
+#include "maiken/lock.hpp"
 #include "maiken/scm.hpp"
 
-void maiken::Application::loadDepOrMod(YAML::Node const& node, const kul::Dir& depOrMod,
-                                       bool module) KTHROW(kul::Exception) {
-  KOUT(NON) << MKN_PROJECT_NOT_FOUND << depOrMod;
-#ifdef _MKN_DISABLE_SCM_
-  KEXIT(1, "dep does not exist and remote retrieval is disabled - path: " + depOrMod.path());
-#endif
-  if (!node[STR_SCM] && !node[STR_NAME])
-    KEXIT(1,
-          "dep has no name or scm tag so cannot be resolved automatically from "
-          "remote repositories - path: " +
-              depOrMod.path());
+// queues the clone, popDepOrMod waits for it before loading the project
+void maiken::Application::fetchDepOrMod(YAML::Node const& node, const kul::Dir& depOrMod,
+                                        bool module) KTHROW(kul::Exception) {
+  if (node[STR_LOCAL] || (!node[STR_SCM] && !node[STR_NAME])) return;
   kul::env::CWD(this->project().dir());
   std::string const& tscr(node[STR_SCM] ? Properties::RESOLVE(*this, node[STR_SCM].Scalar())
                                         : node[STR_NAME].Scalar());
   std::string const& v(node[STR_VERSION] ? Properties::RESOLVE(*this, node[STR_VERSION].Scalar())
                                          : "");
-  try {
-    KOUT(NON) << SCMGetter::GET(depOrMod, tscr, module)
-                     ->co(depOrMod.path(), SCMGetter::REPO(depOrMod, tscr, module), v);
-  } catch (const kul::scm::Exception& e) {
-    if (node[STR_NAME]) {
-      kul::File version(".mkn/dep/ver/" + node[STR_NAME].Scalar());
-      if (version) version.rm();
+  std::string const& profiles(
+      node[STR_PROFILE] ? Properties::RESOLVE(*this, node[STR_PROFILE].Scalar()) : "");
+  SCMFetcher::INSTANCE().fetch(depOrMod, tscr, v, module, profiles);
+}
+
+void maiken::Application::loadDepOrMod(YAML::Node const& node, const kul::Dir& depOrMod,
+                                       bool module, bool fetched) KTHROW(kul::Exception) {
+  if (!fetched) {
+    KOUT(NON) << MKN_PROJECT_NOT_FOUND << depOrMod;
+#ifdef _MKN_DISABLE_SCM_
+    KEXIT(1, "dep does not exist and remote retrieval is disabled - path: " + depOrMod.path());
+#endif
+    if (!node[STR_SCM] && !node[STR_NAME])
+      KEXIT(1,
+            "dep has no name or scm tag so cannot be resolved automatically from "
+            "remote repositories - path: " +
+                depOrMod.path());
+    kul::env::CWD(this->project().dir());
+    std::string const& tscr(node[STR_SCM] ? Properties::RESOLVE(*this, node[STR_SCM].Scalar())
+                                          : node[STR_NAME].Scalar());
+    std::string const& v(
+        node[STR_VERSION] ? Properties::RESOLVE(*this, node[STR_VERSION].Scalar()) : "");
+    try {
+      KOUT(NON) << SCMGetter::CO(SCMGetter::GET(depOrMod, tscr, module), depOrMod,
+                                 SCMGetter::REPO(depOrMod, tscr, module), v);
+    } catch (const kul::scm::Exception& e) {
+      if (node[STR_NAME]) {
+        kul::File version(".mkn/dep/ver/" + node[STR_NAME].Scalar());
+        if (version) version.rm();
+      }
+      std::rethrow_exception(std::current_exception());
     }
-    std::rethrow_exception(std::current_exception());
   }
   kul::env::CWD(depOrMod);
 
@@ -84,8 +101,14 @@ kul::Dir maiken::Application::resolveDepOrModDirectory(YAML::Node const& n, bool
     d = Properties::RESOLVE(*this, n[STR_LOCAL].Scalar());
   else {
     std::string depName{n[STR_NAME].Scalar()};
-    std::string name(Properties::RESOLVE(*this, depName));
-    d = (*AppVars::INSTANCE().properkeys().find(module ? "MKN_MOD_REPO" : "MKN_REPO")).second;
+    std::string const name(Properties::RESOLVE(*this, depName));
+    // properties may change what an unchanged node resolves to
+    YAML::Node resolved(YAML::Clone(n));
+    for (auto const* key : {STR_NAME, STR_VERSION, STR_SCM, STR_PROFILE})
+      if (n[key]) resolved[key] = Properties::RESOLVE(*this, n[key].Scalar());
+    auto& lock(LockFile::INSTANCE());
+    std::string const project(this->project().dir().real());
+    if (auto const* entry = lock.find(project, resolved, module)) return kul::Dir(entry->directory);
     try {
       kul::File verFile(depName, ".mkn/dep/ver");
       auto resolveSCMBranch = [=]() -> std::string {
@@ -112,10 +135,8 @@ kul::Dir maiken::Application::resolveDepOrModDirectory(YAML::Node const& n, bool
         verFile.dir().mk();
         kul::io::Writer(verFile) << version;
       }
-      if (_MKN_REP_VERS_DOT_) kul::String::REPLACE_ALL(version, ".", kul::Dir::SEP());
-
-      if (_MKN_REP_NAME_DOT_) kul::String::REPLACE_ALL(name, ".", kul::Dir::SEP());
-      d = kul::Dir::JOIN(d, kul::Dir::JOIN(name, version));
+      d = SCMFetcher::DIRECTORY(name, version, module);
+      lock.add(project, resolved, module, d, version);
     } catch (kul::Exception const& e) {
       KERR << e.debug();
     }
@@ -144,6 +165,12 @@ void maiken::Application::popDepOrMod(YAML::Node const& n, std::vector<Applicati
     bool f = false;
     for (Application const* ap : vec)
       if (projectDir == ap->project().dir() && p == ap->p) return;
+    bool const fetched = SCMFetcher::INSTANCE().wait(projectDir);
+    if (fetched || !projectDir.is()) {
+      std::string const& cwd(kul::env::CWD());
+      loadDepOrMod(depOrMod, projectDir, module, fetched);
+      kul::env::CWD(cwd);
+    }
 
     maiken::Project const& c(*maiken::Projects::INSTANCE().getOrCreate(projectDir));
 
@@ -219,6 +246,9 @@ void maiken::Application::popDepOrMod(YAML::Node const& n, std::vector<Applicati
 
   cyclicCheck(apps);
 
+  // projects already updated in this run are skipped by their path
+  if (AppVars::INSTANCE().fupdate()) SCM_UPDATE(vec);
+
   auto cmds = maiken::AppVars::INSTANCE().commands();
   for (auto* ap : vec) {
     auto& app(*ap);
@@ -0,0 +1,159 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#if defined(_MKN_WITH_MKN_RAM_) && defined(_MKN_WITH_IO_CEREAL_)
+
+#include "maiken/dist.hpp"
+
+namespace {
+constexpr size_t MIN_MATCH = 4, HASH_BITS = 16, WINDOW = 1 << 16;
+
+uint32_t read32(uint8_t const* p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+uint32_t hash(uint8_t const* p) { return (read32(p) * 2654435761u) >> (32 - HASH_BITS); }
+
+// lengths over 15 continue in following bytes, 255 meaning more follows
+bool put_length(size_t n, uint8_t*& op, uint8_t const* end) {
+  for (; n >= 255; n -= 255) {
+    if (op == end) return false;
+    *op++ = 255;
+  }
+  if (op == end) return false;
+  *op++ = static_cast<uint8_t>(n);
+  return true;
+}
+
+// token(literals:4|match:4) [literal length] literals [offset:16 [match length]]
+//  the final sequence is literals only
+bool put_sequence(uint8_t const* lit, size_t lit_len, size_t offset, size_t match_len,
+                  uint8_t*& op, uint8_t const* end) {
+  size_t const ml = match_len ? match_len - MIN_MATCH : 0;
+  if (op == end) return false;
+  *op++ = static_cast<uint8_t>((std::min<size_t>(lit_len, 15) << 4) | std::min<size_t>(ml, 15));
+  if (lit_len >= 15 && !put_length(lit_len - 15, op, end)) return false;
+  if (static_cast<size_t>(end - op) < lit_len) return false;
+  std::memcpy(op, lit, lit_len);
+  op += lit_len;
+  if (!match_len) return true;
+  if (end - op < 2) return false;
+  *op++ = static_cast<uint8_t>(offset);
+  *op++ = static_cast<uint8_t>(offset >> 8);
+  return ml < 15 || put_length(ml - 15, op, end);
+}
+}  // namespace
+
+size_t maiken::dist::Codec::COMPRESS(uint16_t level, uint8_t const* in, size_t len,
+                                     uint8_t* out) {
+  if (level == 0 || len <= MIN_MATCH) return 0;
+  size_t const depth = size_t{1} << (std::min(level, MAX_LEVEL) - 1);
+
+  // positions are stored + 1 so 0 is empty
+  static thread_local std::vector<uint32_t> head, chain;
+  head.assign(size_t{1} << HASH_BITS, 0);
+  chain.resize(WINDOW);
+
+  uint8_t* op = out;
+  uint8_t const* const end = out + len - 1;
+  size_t anchor = 0, pos = 0;
+  auto const insert = [&](size_t p) {
+    uint32_t const h = hash(in + p);
+    chain[p & (WINDOW - 1)] = head[h];
+    head[h] = static_cast<uint32_t>(p + 1);
+  };
+  while (pos + MIN_MATCH <= len) {
+    size_t best_len = 0, best_off = 0;
+    uint32_t cand = head[hash(in + pos)];
+    for (size_t d = 0; cand && d < depth; d++) {
+      size_t const c = cand - 1;
+      if (pos - c >= WINDOW) break;
+      if (read32(in + c) == read32(in + pos)) {
+        size_t l = MIN_MATCH;
+        while (pos + l < len && in[c + l] == in[pos + l]) l++;
+        if (l > best_len) best_len = l, best_off = pos - c;
+      }
+      cand = chain[c & (WINDOW - 1)];
+      if (cand && cand - 1 >= c) break;  // slot reused by a newer position
+    }
+    insert(pos);
+    if (best_len < MIN_MATCH) {
+      pos++;
+      continue;
+    }
+    if (!put_sequence(in + anchor, pos - anchor, best_off, best_len, op, end)) return 0;
+    for (size_t i = pos + 1; i < pos + best_len && i + MIN_MATCH <= len; i++) insert(i);
+    pos += best_len;
+    anchor = pos;
+  }
+  if (!put_sequence(in + anchor, len - anchor, 0, 0, op, end)) return 0;
+  return static_cast<size_t>(op - out);
+}
+
+void maiken::dist::Codec::DECOMPRESS(uint8_t const* in, size_t len, uint8_t* out,
+                                     size_t out_len) KTHROW(maiken::dist::Exception) {
+  uint8_t const* ip = in;
+  uint8_t const* const ie = in + len;
+  uint8_t* op = out;
+  uint8_t* const oe = out + out_len;
+  auto const length = [&](size_t n) {
+    if (n == 15) {
+      uint8_t b = 255;
+      while (b == 255) {
+        if (ip == ie) KEXCEPT(Exception, "Compressed payload is truncated");
+        n += (b = *ip++);
+      }
+    }
+    return n;
+  };
+  while (ip < ie) {
+    uint8_t const token = *ip++;
+    size_t const lit = length(token >> 4);
+    if (static_cast<size_t>(ie - ip) < lit || static_cast<size_t>(oe - op) < lit)
+      KEXCEPT(Exception, "Compressed payload literals out of bounds");
+    std::memcpy(op, ip, lit);
+    op += lit;
+    ip += lit;
+    if (ip == ie) break;
+    if (ie - ip < 2) KEXCEPT(Exception, "Compressed payload is truncated");
+    size_t const offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    size_t const ml = length(token & 15) + MIN_MATCH;
+    if (!offset || offset > static_cast<size_t>(op - out) || static_cast<size_t>(oe - op) < ml)
+      KEXCEPT(Exception, "Compressed payload match out of bounds");
+    uint8_t const* match = op - offset;
+    for (size_t i = 0; i < ml; i++) op[i] = match[i];  // may overlap
+    op += ml;
+  }
+  if (op != oe) KEXCEPT(Exception, "Compressed payload size mismatch");
+}
+
+#endif  // _MKN_WITH_MKN_RAM_ && _MKN_WITH_IO_CEREAL_
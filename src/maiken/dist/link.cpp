@@ -0,0 +1,71 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#if defined(_MKN_WITH_MKN_RAM_) && defined(_MKN_WITH_IO_CEREAL_)
+
+#include "maiken/dist.hpp"
+
+void maiken::DistLinker::send(kul::File const& bin) KTHROW(kul::Exception) {
+  using namespace maiken::dist;
+  auto const data(Store::READ(bin));
+  std::vector<std::string> chunks;
+  kul::hash::map::S2T<std::pair<size_t, size_t>> ranges;
+  for (auto const& chunk : Store::CHUNKS(data.data(), data.size())) {
+    chunks.emplace_back(Store::HASH(data.data() + chunk.first, chunk.second) + ".chunk");
+    ranges.insert(chunks.back(), chunk);
+  }
+
+  // a node that cannot take the binary is left out of the rest of the build, whatever it would
+  //  have linked against it is built here instead
+  auto post_lambda = [&](Host const& host) {
+    try {
+      for (auto const& blob : Store::MISSING(host, chunks)) {
+        auto const& range = ranges.at(blob);
+        Store::UPLOAD(host, blob, data.data() + range.first, range.second);
+      }
+      Post(RemoteCommandManager::INST().build_link_request(bin.real(), chunks)).send(host);
+    } catch (const std::exception& e) {
+      KERR << "Excluding node " << host.host() << ", failed to send " << bin.real() << " : "
+           << e.what();
+      host.exclude();
+    }
+  };
+
+  std::vector<Host const*> hosts;
+  for (auto const& host : RemoteCommandManager::INST().hosts())
+    if (host.alive()) hosts.emplace_back(&host);
+  if (hosts.empty()) return;
+  kul::ChroncurrentThreadPool<> ctp(hosts.size(), 1, 1000000, 1000);
+  for (auto const* host : hosts) ctp.async(std::bind(post_lambda, std::cref(*host)));
+  ctp.finish(10000000);  // 10 milliseconds
+  ctp.rethrow();
+}
+
+#endif  // _MKN_WITH_MKN_RAM_ && _MKN_WITH_IO_CEREAL_
@@ -31,13 +31,13 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #if defined(_MKN_WITH_MKN_RAM_) && defined(_MKN_WITH_IO_CEREAL_)
 
 #include "maiken/dist.hpp"
+#include "maiken/toolchain.hpp"
 
-void maiken::dist::SetupRequest::do_response_for(const kul::http::A1_1Request& req,
-                                                 Sessions& sessions,
-                                                 kul::http::_1_1Response& resp) {
-  if (!req.header("session")) KEXCEPTION("BAD 41");  // resp.withBody("FAILUIRE");
-  auto session_id = (*req.headers().find("session")).second;
+#include <cstdlib>
 
+void maiken::dist::SetupRequest::do_response_for(const kul::http::A1_1Request& /*req*/,
+                                                 ServerSession& session,
+                                                 kul::http::_1_1Response& resp) {
   YAML::Node root;
   bool success = 1;
   if (success)
@@ -48,25 +48,46 @@ void maiken::dist::SetupRequest::do_response_for(const kul::http::A1_1Request& r
   }
   YAML::Emitter out;
   out << root;
-  sessions[session_id].reset_setup(this);
-  sessions[session_id].setup_ptr()->m_args.erase(STR_NODES);
-  sessions[session_id].set_apps(
-      maiken::Application::CREATE(sessions[session_id].setup_ptr()->m_args));
+  m_args.erase(STR_NODES);
+  // without a copy of the project only preprocessed units can be compiled
+  std::string const directory(YAML::Load(m_project_yaml)["directory"].Scalar());
+  if (kul::Dir(directory)) {
+    auto turn(session.setup_turn());
+    auto& setups(session.setups());
+    auto const key(SetupCache::KEY(directory, m_project_yaml, m_settings_yaml, m_args));
+    if (auto const* entry = setups.find(directory, key))
+      session.set_apps(entry->apps);
+    else {
+      setups.forget(directory);
+      kul::os::PushDir pushd(directory);
+      auto apps(maiken::Application::CREATE(m_args));
+      setups.store(directory, key, apps);
+      session.set_apps(apps);
+    }
+  }
+  session.reset_setup(this);
 
   resp.withBody(std::string(out.c_str()));
 }
 
-void maiken::dist::CompileRequest::do_response_for(const kul::http::A1_1Request& req,
-                                                   Sessions& sessions,
+void maiken::dist::CompileRequest::do_response_for(const kul::http::A1_1Request& /*req*/,
+                                                   ServerSession& session,
                                                    kul::http::_1_1Response& resp) {
-  if (!req.header("session")) KEXCEPTION("BAD CompileRequest");
-  auto session_id = (*req.headers().find("session")).second;
-
-  kul::env::CWD(this->m_directory);
-
-  std::vector<kul::File> cacheFiles;
-  sessions[session_id].apps_vector()[0]->compile(this->m_src_obj, sessions[session_id].objects,
-                                                 cacheFiles);
+  if (!m_units.empty()) {
+    YAML::Node root;
+    compile_preprocessed(session, root);
+    YAML::Emitter out;
+    out << root;
+    resp.withBody(std::string(out.c_str()));
+    return;
+  }
+  if (session.apps_vector().empty()) KEXCEPTION("CompileRequest without setup");
+  {
+    auto turn(session.compile_turn(session.apps_vector()[0]->project().dir().real()));
+    std::vector<kul::File> cacheFiles;
+    session.apps_vector()[0]->compile(this->m_src_obj, session.objects, cacheFiles,
+                                      session.app_vars());
+  }
 
   YAML::Node root;
   bool success = 1;
@@ -79,31 +100,156 @@ void maiken::dist::CompileRequest::do_response_for(const kul::http::A1_1Request&
   root["files"] = this->m_src_obj.size();
   YAML::Emitter out;
   out << root;
-  sessions[session_id].m_src_obj = std::move(this->m_src_obj);
+  session.m_downloads.clear();
+  for (auto const& so : this->m_src_obj) session.m_downloads.emplace_back(so.second, so.second);
   resp.withBody(std::string(out.c_str()));
 }
 
-void maiken::dist::LinkRequest::do_response_for(const kul::http::A1_1Request& req,
-                                                Sessions& sessions, kul::http::_1_1Response& resp) {
-  if (!req.header("session")) KEXCEPTION("BAD LinkRequest");
-  auto session_id = (*req.headers().find("session")).second;
+void maiken::dist::CompileRequest::compile_preprocessed(ServerSession& session, YAML::Node& root) {
+  auto const replace = [](std::string& s, std::string const& token, std::string const& with) {
+    auto const pos = s.find(token);
+    if (pos != std::string::npos) s.replace(pos, token.size(), with);
+  };
+  auto& cache(session.cache());
+  kul::Dir const store(session.store().dir()), sandbox(session.sandbox());
+  std::vector<std::pair<std::string, std::string>> downloads;
+  std::vector<std::tuple<std::string, kul::File, std::string>> compiles;  // cmd, object, key
+  for (size_t i = 0; i < m_units.size(); i++) {
+    auto const& unit = m_units[i];
+    if (!PreprocessedUnit::VALID_BLOB(unit.blob())) KEXCEPTION("Invalid unit: ") << unit.blob();
+    std::string const key(cache.key(unit));
+    downloads.emplace_back(cache.file(key).full(), unit.obj);
+    if (cache.has(key)) continue;
+    kul::File const in(unit.blob(), store);
+    if (!in) KEXCEPTION("Unit not uploaded: ") << unit.blob();
+    session.store().use(unit.blob());
+    kul::File const obj(std::to_string(i) + ".o", sandbox);
+    std::string cmd(ObjectCache::COMMAND(unit));
+    replace(cmd, unit.in, in.escm());
+    replace(cmd, PreprocessedUnit::OUT_TOKEN, obj.escm());
+    compiles.emplace_back(std::move(cmd), obj, key);
+  }
+
+  std::mutex mute;
+  std::stringstream errors;
+  if (!compiles.empty()) {
+    // only the units' own files are used, sessions compile them at once
+    kul::ChroncurrentThreadPool<> ctp(kul::cpu::threads(), 1, 1000000000, 1000);
+    for (auto const& compile : compiles)
+      ctp.async([&compile, &cache, &mute, &errors]() {
+        auto const& cmd(std::get<0>(compile));
+        kul::Process p(cmd);
+        kul::ProcessCapture pc(p);
+        try {
+          p.start();
+          cache.store(std::get<1>(compile), std::get<2>(compile));
+        } catch (kul::Exception const& e) {
+          std::lock_guard<std::mutex> lock(mute);
+          errors << cmd << kul::os::EOL() << pc.errs() << kul::os::EOL();
+        }
+      });
+    ctp.finish(1000000 * 1000);
+    ctp.rethrow();
+  }
+
+  root["files"] = m_units.size();
+  if (errors.str().empty()) {
+    root["status"] = 0;
+    session.m_downloads = std::move(downloads);
+  } else {
+    root["status"] = 1;
+    root["message"] = errors.str();
+    session.m_downloads.clear();
+  }
+}
 
+void maiken::dist::StatusRequest::do_response_for(const kul::http::A1_1Request& /*req*/,
+                                                  ServerSession& /*session*/,
+                                                  kul::http::_1_1Response& resp) {
+  YAML::Node root;
+  root["status"] = 0;
+  root["cores"] = kul::cpu::threads();
+  double load = 0;
+#ifndef _WIN32
+  if (getloadavg(&load, 1) != 1) load = 0;
+#endif  // _WIN32
+  root["load"] = static_cast<uint16_t>(load + 0.5);
+  auto& toolchain(Toolchain::INSTANCE());
+  std::string const path(kul::env::GET("PATH"));
+  for (auto const& compiler : m_compilers) {
+    std::string const bin(toolchain.which(compiler, path));
+    root["toolchain"][compiler] = bin.empty() ? "" : toolchain.version(bin);
+  }
+  toolchain.write();  // nodes run until stopped
+  YAML::Emitter out;
+  out << root;
+  resp.withBody(std::string(out.c_str()));
+}
+
+void maiken::dist::ManifestRequest::do_response_for(const kul::http::A1_1Request& /*req*/,
+                                                    ServerSession& session,
+                                                    kul::http::_1_1Response& resp) {
+  kul::Dir const store(session.store().dir());
+  YAML::Node root;
+  root["status"] = 0;
+  root["missing"] = YAML::Node(YAML::NodeType::Sequence);
+  for (auto const& blob : m_blobs) {
+    if (!PreprocessedUnit::VALID_BLOB(blob)) KEXCEPTION("Invalid blob: ") << blob;
+    if (kul::File(blob, store))
+      session.store().use(blob);  // the client will not upload it again
+    else
+      root["missing"].push_back(blob);
+  }
+  YAML::Emitter out;
+  out << root;
+  resp.withBody(std::string(out.c_str()));
+}
+
+void maiken::dist::UploadRequest::do_response_for(const kul::http::A1_1Request& /*req*/,
+                                                  ServerSession& session,
+                                                  kul::http::_1_1Response& resp) {
   Blob b;
   std::istringstream iss(this->str);
   {
     cereal::PortableBinaryInputArchive iarchive(iss);
     iarchive(b);
   }
-  kul::File obj(b.file);
-  if (obj) obj = kul::File(std::string(b.file + ".new"));
-  if (!sessions[session_id].binary_writer) {
-    obj.rm();
-    sessions[session_id].binary_writer = std::make_unique<kul::io::BinaryWriter>(obj);
+  b.decompress();
+  kul::Dir const store(session.store().dir());
+  size_t offset = 0;
+  for (auto segment : b.segments) {
+    if (!PreprocessedUnit::VALID_BLOB(segment.file)) KEXCEPTION("Invalid blob: ") << segment.file;
+    session.store().use(segment.file);
+    segment.file = store.join(segment.file);
+    session.upload.write(segment, b.c1 + offset);
+    offset += segment.len;
   }
+  YAML::Node root;
+  root["status"] = 0;
+  YAML::Emitter out;
+  out << root;
+  resp.withBody(std::string(out.c_str()));
+}
 
-  kul::io::BinaryWriter& bw(*sessions[session_id].binary_writer.get());
-  bw.write(b.c1, b.len);
-  if (b.last_packet) sessions[session_id].binary_writer.reset();
+void maiken::dist::LinkRequest::do_response_for(const kul::http::A1_1Request& /*req*/,
+                                                ServerSession& session,
+                                                kul::http::_1_1Response& resp) {
+  kul::Dir const store(session.store().dir());
+  for (auto const& chunk : m_chunks) {
+    if (!PreprocessedUnit::VALID_BLOB(chunk) || !kul::File(chunk, store))
+      KEXCEPTION("Chunk not uploaded: ") << chunk;
+    session.store().use(chunk);
+  }
+  // written beside the binary and moved over it, a running copy keeps its own
+  FileWriter fw;
+  Blob::Segment segment;
+  segment.file = m_file;
+  for (size_t i = 0; i < m_chunks.size(); i++) {
+    auto const data(Store::READ(kul::File(m_chunks[i], store)));
+    segment.len = data.size();
+    segment.last = i + 1 == m_chunks.size();
+    fw.write(segment, data.data());
+  }
 
   YAML::Node root;
   bool success = 1;
@@ -119,33 +265,34 @@ void maiken::dist::LinkRequest::do_response_for(const kul::http::A1_1Request& re
 }
 
 void maiken::dist::DownloadRequest::do_response_for(const kul::http::A1_1Request& req,
-                                                    Sessions& sessions,
+                                                    ServerSession& session,
                                                     kul::http::_1_1Response& resp) {
-  if (!req.header("session")) KEXCEPTION("BAD DownloadRequest");
-  auto session_id = (*req.headers().find("session")).second;
-
-  auto& src_obj = sessions[session_id].m_src_obj;
-  if (!sessions[session_id].binary_reader) {
-    if (!src_obj.empty()) {
-      auto& pair = src_obj[0];
-      kul::File bin(pair.second);
-      sessions[session_id].binary_reader = std::make_unique<kul::io::BinaryReader>(bin);
-    }
-  }
+  auto& src_obj = session.m_downloads;
 
+  // fill the message with as many whole or partial objects as fit
   Blob b;
-  b.files_left = src_obj.size();
-  bzero(b.c1, BUFF_SIZE);
-  b.file = src_obj[0].second;
-  auto& br(*sessions[session_id].binary_reader.get());
-  size_t red = b.len = br.read(b.c1, BUFF_SIZE);
-  if (red == 0) {
+  size_t used = 0;
+  while (!src_obj.empty()) {
+    Blob::Segment segment;
+    segment.file = src_obj[0].second;
+    used += Blob::Segment::OVERHEAD(segment.file);
+    if (used >= BUFF_SIZE) break;
+    if (!session.binary_reader)
+      session.binary_reader = std::make_unique<kul::io::BinaryReader>(kul::File(src_obj[0].first));
+    size_t const want = BUFF_SIZE - used;
+    segment.len = session.binary_reader->read(b.c1 + b.len, want);
+    b.len += segment.len;
+    used += segment.len;
+    segment.last = segment.len < want;
+    b.segments.emplace_back(segment);
+    if (!segment.last) break;
+    session.binary_reader.reset();
     src_obj.erase(src_obj.begin());
-    b.files_left = src_obj.size();
-    sessions[session_id].binary_reader.reset();
-    // if (b.files_left == 0) sessions.erase(req.ip());
-    b.last_packet = 1;
   }
+  b.files_left = src_obj.size();
+  if (req.header("compress"))
+    b.compress(std::min(kul::String::UINT16((*req.headers().find("compress")).second),
+                        Codec::MAX_LEVEL));
   std::ostringstream ss(std::ios::out | std::ios::binary);
   {
     cereal::PortableBinaryOutputArchive oarchive(ss);
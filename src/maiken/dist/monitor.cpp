@@ -0,0 +1,109 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#if defined(_MKN_WITH_MKN_RAM_) && defined(_MKN_WITH_IO_CEREAL_)
+
+#include "maiken/dist.hpp"
+#include "maiken/toolchain.hpp"
+
+YAML::Node maiken::dist::NodeMonitor::STATUS(Host const& host,
+                                             std::vector<std::string> const& compilers) {
+  Post post(RemoteCommandManager::INST().build_status_request(compilers));
+  post.send(host);
+  YAML::Node const reply = YAML::Load(post.body());
+  if (!reply["status"] || reply["status"].Scalar() != "0")
+    KEXCEPT(Exception, "Node status failed: ") << host.host();
+  host.capacity(kul::String::UINT16(reply["cores"].Scalar()),
+                kul::String::UINT16(reply["load"].Scalar()));
+  return reply;
+}
+
+bool maiken::dist::NodeMonitor::HANDSHAKE(Application const& app, Host const& host) {
+  std::vector<std::string> compilers;
+  for (auto const& ft : app.files()) {
+    if (!ft.second.count(STR_COMPILER)) continue;
+    auto const bits(kul::cli::asArgs(ft.second.at(STR_COMPILER)));
+    if (!bits.empty() && std::find(compilers.begin(), compilers.end(), bits[0]) == compilers.end())
+      compilers.emplace_back(bits[0]);
+  }
+  try {
+    auto const reply = STATUS(host, compilers);
+    auto& toolchain(Toolchain::INSTANCE());
+    std::string const path(kul::env::GET("PATH"));
+    for (auto const& compiler : compilers) {
+      std::string const bin(toolchain.which(compiler, path));
+      std::string const local(bin.empty() ? "" : toolchain.version(bin));
+      std::string const remote(reply["toolchain"] && reply["toolchain"][compiler]
+                                   ? reply["toolchain"][compiler].Scalar()
+                                   : "");
+      if (local != remote) {
+        KERR << "Node " << host.host() << " compiler " << compiler << " differs: \"" << remote
+             << "\" not \"" << local << "\", node unused";
+        return false;
+      }
+    }
+  } catch (std::exception const& e) {
+    KERR << "Node " << host.host() << " unreachable, node unused: " << e.what();
+    return false;
+  }
+  return true;
+}
+
+maiken::dist::NodeMonitor::NodeMonitor(std::vector<Host> const& hosts, size_t const n) {
+  for (size_t i = 0; i < n && i < hosts.size(); i++)
+    if (!hosts[i].excluded()) threads.emplace_back(&NodeMonitor::beat, this, std::cref(hosts[i]));
+}
+
+maiken::dist::NodeMonitor::~NodeMonitor() {
+  {
+    std::lock_guard<std::mutex> lock(mute);
+    running = 0;
+  }
+  cv.notify_all();
+  // a heartbeat being sent is waited on
+  for (auto& t : threads) t.join();
+}
+
+void maiken::dist::NodeMonitor::beat(Host const& host) {
+  while (running) {
+    try {
+      STATUS(host, {});
+      if (!host.alive() && running) KOUT(NON) << "Node " << host.host() << " is back";
+      host.alive(1);
+    } catch (std::exception const& e) {
+      if (host.alive() && running) KERR << "Node " << host.host() << " is down: " << e.what();
+      host.alive(0);
+    }
+    std::unique_lock<std::mutex> lock(mute);
+    cv.wait_for(lock, std::chrono::seconds(2), [&] { return !running; });
+  }
+}
+
+#endif  // _MKN_WITH_MKN_RAM_ && _MKN_WITH_IO_CEREAL_
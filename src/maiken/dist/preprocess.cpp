@@ -0,0 +1,75 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#if defined(_MKN_WITH_MKN_RAM_) && defined(_MKN_WITH_IO_CEREAL_)
+
+#include "maiken/dist.hpp"
+
+std::vector<maiken::dist::PreprocessedUnit> maiken::dist::Preprocessor::PREPARE(
+    Application& app, Host const& host, std::vector<Unit> const& batch) KTHROW(kul::Exception) {
+  kul::os::PushDir pushd(app.project().dir());
+  ThreadingCompiler tc(app);
+  std::vector<CompilationUnit> c_units;
+  for (auto const& so : batch) {
+    c_units.emplace_back(tc.compilationUnit(so));
+    if (!dynamic_cast<cpp::GccCompiler const*>(c_units.back().comp)) return {};
+  }
+
+  std::vector<PreprocessedUnit> units;
+  std::vector<std::string> blobs;
+  kul::hash::map::S2T<std::vector<uint8_t>> contents;
+  for (auto const& c_unit : c_units) {
+    std::string const ext(c_unit.in.substr(c_unit.in.rfind(".") + 1));
+    PreprocessedUnit unit;
+    unit.ext = kul::String::NO_CASE_CMP(ext, "c") ? "i" : "ii";
+    kul::File const file(c_unit.out + "." + unit.ext);
+    auto const cpc = c_unit.preprocess(file.full());
+    if (cpc.exception()) std::rethrow_exception(cpc.exception());
+    auto data(Store::READ(file));
+    file.rm();
+    unit.hash = Store::HASH(data.data(), data.size());
+    unit.in = std::string(PreprocessedUnit::IN_TOKEN) + "." + ext;
+    unit.cmd = c_unit.compileString(unit.in, PreprocessedUnit::OUT_TOKEN);
+    unit.obj = c_unit.out;
+    if (!contents.count(unit.blob())) {
+      blobs.emplace_back(unit.blob());
+      contents.insert(unit.blob(), std::move(data));
+    }
+    units.emplace_back(std::move(unit));
+  }
+
+  for (auto const& blob : Store::MISSING(host, blobs)) {
+    auto const& data = contents.at(blob);
+    Store::UPLOAD(host, blob, data.data(), data.size());
+  }
+  return units;
+}
+
+#endif  // _MKN_WITH_MKN_RAM_ && _MKN_WITH_IO_CEREAL_
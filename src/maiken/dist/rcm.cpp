@@ -69,14 +69,36 @@ maiken::dist::RemoteCommandManager::build_compile_request(
   return std::make_unique<maiken::dist::CompileRequest>(directory, src_objs);
 }
 
+std::unique_ptr<maiken::dist::CompileRequest>
+maiken::dist::RemoteCommandManager::build_compile_request(
+    std::vector<PreprocessedUnit> const& units) {
+  return std::make_unique<maiken::dist::CompileRequest>(units);
+}
+
+std::unique_ptr<maiken::dist::ManifestRequest>
+maiken::dist::RemoteCommandManager::build_manifest_request(std::vector<std::string> const& blobs) {
+  return std::make_unique<maiken::dist::ManifestRequest>(blobs);
+}
+
+std::unique_ptr<maiken::dist::UploadRequest>
+maiken::dist::RemoteCommandManager::build_upload_request(std::string const& b) {
+  return std::make_unique<maiken::dist::UploadRequest>(b);
+}
+
+std::unique_ptr<maiken::dist::StatusRequest>
+maiken::dist::RemoteCommandManager::build_status_request(
+    std::vector<std::string> const& compilers) {
+  return std::make_unique<maiken::dist::StatusRequest>(compilers);
+}
+
 std::unique_ptr<maiken::dist::DownloadRequest>
 maiken::dist::RemoteCommandManager::build_download_request() {
   return std::make_unique<maiken::dist::DownloadRequest>();
 }
 
 std::unique_ptr<maiken::dist::LinkRequest> maiken::dist::RemoteCommandManager::build_link_request(
-    std::string const& b) {
-  return std::make_unique<maiken::dist::LinkRequest>(b);
+    std::string const& file, std::vector<std::string> const& chunks) {
+  return std::make_unique<maiken::dist::LinkRequest>(file, chunks);
 }
 
 #endif  // _MKN_WITH_MKN_RAM_ && _MKN_WITH_IO_CEREAL_
@@ -30,13 +30,312 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #if defined(_MKN_WITH_MKN_RAM_) && defined(_MKN_WITH_IO_CEREAL_)
 
+#include <algorithm>
+#include <fstream>
+#include <functional>
 #include <iomanip>
+#include <iterator>
 #include "maiken/dist.hpp"
+#include "maiken/toolchain.hpp"
+
+maiken::dist::ServerSession* maiken::dist::Server::session(std::string const& id,
+                                                            bool const create) {
+  // the id names the session's sandbox directory
+  if (!PreprocessedUnit::VALID_BLOB(id)) return nullptr;
+  std::lock_guard<std::mutex> lock(mute);
+  prune();
+  auto it = sessions.find(id);
+  if (it == sessions.end()) {
+    if (!create) return nullptr;
+    it = sessions
+             .emplace(std::piecewise_construct, std::forward_as_tuple(id),
+                      std::forward_as_tuple(id, scheduler, store, cache, setups, m_home))
+             .first;
+  }
+  auto& sesh(it->second);
+  sesh.used = kul::Now::MILLIS();
+  sesh.active++;
+  return &sesh;
+}
+
+void maiken::dist::Server::prune() {
+  auto const now = kul::Now::MILLIS();
+  for (auto it = sessions.begin(); it != sessions.end();) {
+    auto const& sesh(it->second);
+    if (sesh.active || now - sesh.used < SESSION_IDLE) {
+      ++it;
+      continue;
+    }
+    kul::Dir const sandbox(kul::Dir::JOIN(m_home.join("sessions"), sesh.id()));
+    try {
+      if (sandbox) sandbox.rm();
+    } catch (const kul::Exception& e) {
+      KLOG(ERR) << "Failed to remove session sandbox: " << sandbox.path() << " : " << e.what();
+    }
+    scheduler.forget(sesh.id());
+    it = sessions.erase(it);
+  }
+  uint64_t oldest = setups.generation();
+  for (auto const& sesh : sessions) oldest = std::min(oldest, sesh.second.generation.load());
+  setups.release(oldest);
+  if (now - swept < STORE_SWEEP) return;
+  // a client may rely on anything the node had during its requests
+  for (auto const& sesh : sessions)
+    if (sesh.second.active) return;
+  swept = now;
+  store.evict(STORE_IDLE);
+  cache.evict(STORE_IDLE);
+}
+
+void maiken::dist::IdleFiles::evict(uint64_t const idle) {
+  auto const now = kul::Now::MILLIS();
+  std::lock_guard<std::mutex> lock(mute);
+  for (auto const& f : m_dir.files()) {
+    auto it = used.find(f.name());
+    if (it == used.end())
+      used.emplace(f.name(), now);
+    else if (now - it->second >= idle) {
+      try {
+        f.rm();
+        used.erase(it);
+      } catch (const kul::Exception& e) {
+        KLOG(ERR) << "Failed to evict: " << f.real() << " : " << e.what();
+      }
+    }
+  }
+}
+
+std::string maiken::dist::ObjectCache::COMPILER(PreprocessedUnit const& unit)
+    KTHROW(Exception) {
+  auto const bits(kul::cli::asArgs(unit.cmd));
+  if (bits.empty()) KEXCEPTION("Unit without command");
+  std::string const name(bits[0].substr(bits[0].find_last_of("/\\") + 1));
+  std::string const bin(Toolchain::INSTANCE().which(name, kul::env::GET("PATH")));
+  if (bin.empty()) KEXCEPT(Exception, "Compiler not on the node's PATH: ") << name;
+  return bin;
+}
+
+std::string maiken::dist::ObjectCache::COMMAND(PreprocessedUnit const& unit) KTHROW(Exception) {
+  auto const bits(kul::cli::asArgs(unit.cmd));
+  std::string const compiler(COMPILER(unit));
+  return compiler + unit.cmd.substr(unit.cmd.find(bits[0]) + bits[0].size());
+}
+
+std::string maiken::dist::ObjectCache::key(PreprocessedUnit const& unit) const {
+  std::string const bin(COMPILER(unit));
+  std::string const compiler(bin + " " + Toolchain::INSTANCE().version(bin));
+  // options read only by the preprocessor cannot change the object, and name paths of the
+  //  client, so units of the same source on different clients share objects
+  static std::unordered_set<std::string> const separate{
+      "-I", "-D", "-U", "-include", "-imacros", "-isystem", "-iquote", "-idirafter",
+      "-MF", "-MT", "-MQ"};
+  static std::unordered_set<std::string> const alone{"-M", "-MM", "-MD", "-MMD", "-MP"};
+  static std::vector<std::string> const joined{"-I", "-D", "-U", "-isystem", "-iquote",
+                                               "-idirafter"};
+  std::string args;
+  auto const bits(kul::cli::asArgs(unit.cmd));
+  for (size_t i = 1; i < bits.size(); i++) {
+    auto const& b(bits[i]);
+    if (separate.count(b)) {
+      i++;
+      continue;
+    }
+    if (alone.count(b) || std::any_of(joined.begin(), joined.end(), [&](std::string const& j) {
+          return b.compare(0, j.size(), j) == 0;
+        }))
+      continue;
+    args += b;
+    args += '\0';
+  }
+  uint64_t hash = PreprocessedUnit::HASH(unit.blob().data(), unit.blob().size());
+  hash = PreprocessedUnit::HASH(args.data(), args.size(), hash);
+  hash = PreprocessedUnit::HASH(compiler.data(), compiler.size(), hash);
+  std::stringstream ss;
+  ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+  return ss.str();
+}
+
+YAML::Node maiken::dist::ObjectCache::stats() const {
+  uint64_t entries = 0, bytes = 0;
+  for (auto const& f : m_files.dir().files()) {
+    if (f.name().rfind(".o") != f.name().size() - 2) continue;
+    entries++;
+    std::ifstream in(f.real(), std::ios::binary | std::ios::ate);
+    if (in) bytes += static_cast<uint64_t>(in.tellg());
+  }
+  YAML::Node node;
+  node["hits"] = hits.load();
+  node["misses"] = misses.load();
+  node["stores"] = stores.load();
+  node["entries"] = entries;
+  node["bytes"] = bytes;
+  return node;
+}
+
+uint64_t maiken::dist::SetupCache::KEY(std::string const& directory, std::string const& project,
+                                       std::string const& settings, kul::cli::Args const& args) {
+  std::string revision, file;
+  {
+    kul::os::PushDir pushd(directory);
+    try {
+      kul::Process g("git");
+      kul::ProcessCapture gc(g);
+      g.arg("rev-parse").arg("HEAD").start();
+      revision = gc.outs();
+    } catch (const kul::Exception& e) {
+      KLOG(DBG) << "No revision for " << directory << " : " << e.what();
+    }
+    // uncommitted edits to the project file change the graph without changing the revision
+    kul::File yml("mkn.yaml");
+    if (!yml && kul::File("mkn.yml").is()) yml = "mkn.yml";
+    std::ifstream in(yml.real(), std::ios::binary);
+    if (in) file.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  std::stringstream ss;
+  {
+    cereal::PortableBinaryOutputArchive oarchive(ss);
+    oarchive(args);
+  }
+  std::string const arguments(ss.str());
+  uint64_t hash = PreprocessedUnit::HASH_SEED;
+  for (auto const* s : {&directory, &project, &settings, &arguments, &revision, &file}) {
+    uint64_t const size = s->size();  // keeps ("ab", "c") apart from ("a", "bc")
+    hash = PreprocessedUnit::HASH(&size, sizeof(size), hash);
+    hash = PreprocessedUnit::HASH(s->data(), s->size(), hash);
+  }
+  return hash;
+}
+
+uint64_t maiken::dist::SetupCache::FILES(kul::hash::set::String const& projects) {
+  std::vector<std::string> sorted(projects.begin(), projects.end());
+  std::sort(sorted.begin(), sorted.end());
+  uint64_t hash = PreprocessedUnit::HASH_SEED;
+  for (auto const& project : sorted) {
+    std::string file;
+    std::ifstream in(project, std::ios::binary);
+    if (in) file.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    for (auto const* s : {&project, &file}) {
+      uint64_t const size = s->size();
+      hash = PreprocessedUnit::HASH(&size, sizeof(size), hash);
+      hash = PreprocessedUnit::HASH(s->data(), s->size(), hash);
+    }
+  }
+  return hash;
+}
+
+maiken::dist::SetupCache::Entry const* maiken::dist::SetupCache::find(
+    std::string const& directory, uint64_t const key) {
+  std::lock_guard<std::mutex> lock(mute);
+  auto it = m_entries.find(directory);
+  if (it == m_entries.end() || it->second.key != key ||
+      it->second.files != FILES(it->second.projects)) {
+    misses++;
+    return nullptr;
+  }
+  hits++;
+  AppVars::INSTANCE() = *it->second.vars;
+  return &it->second;
+}
+
+void maiken::dist::SetupCache::store(std::string const& directory, uint64_t const key,
+                                     std::vector<Application*> const& apps) {
+  kul::hash::set::String projects;
+  std::unordered_set<Application const*> seen;
+  std::vector<Application const*> todo(apps.begin(), apps.end());
+  while (!todo.empty()) {
+    auto const* app = todo.back();
+    todo.pop_back();
+    if (!seen.insert(app).second) continue;
+    projects.insert(kul::File(app->project().file()).real());
+    for (auto const* dep : app->dependencies()) todo.emplace_back(dep);
+    for (auto const* dep : app->moduleDependencies()) todo.emplace_back(dep);
+  }
+  std::lock_guard<std::mutex> lock(mute);
+  auto& entry(m_entries[directory]);
+  entry.key = key;
+  entry.files = FILES(projects);
+  entry.apps = apps;
+  entry.projects = std::move(projects);
+  entry.vars = std::make_shared<AppVars>(AppVars::INSTANCE());
+}
+
+void maiken::dist::SetupCache::forget(std::string const& directory) {
+  std::lock_guard<std::mutex> lock(mute);
+  kul::Dir const dir(directory);
+  kul::hash::set::String projects;
+  for (auto const* name : {"mkn.yaml", "mkn.yml"}) {
+    kul::File const f(name, dir);
+    if (f) projects.insert(f.real());
+  }
+  // graphs sharing a project share its applications, so go with it
+  for (bool more = 1; more;) {
+    more = 0;
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+      bool const shared = it->first == directory ||
+                          std::any_of(it->second.projects.begin(), it->second.projects.end(),
+                                      [&](std::string const& p) { return projects.count(p); });
+      if (!shared) {
+        ++it;
+        continue;
+      }
+      for (auto const& p : it->second.projects)
+        if (!projects.count(p)) {
+          projects.insert(p);
+          more = 1;
+        }
+      it = m_entries.erase(it);
+    }
+  }
+  Retired retired;
+  retired.generation = m_generation++;
+  for (auto const& p : projects) {
+    kul::File const f(p);
+    for (auto& app : Applications::INSTANCE().forget(f.dir().real()))
+      retired.apps.emplace_back(std::move(app));
+    if (auto project = Projects::INSTANCE().forget(f))
+      retired.projects.emplace_back(std::move(project));
+  }
+  if (!retired.apps.empty() || !retired.projects.empty())
+    m_retired.emplace_back(std::move(retired));
+}
+
+void maiken::dist::SetupCache::release(uint64_t const oldest) {
+  std::lock_guard<std::mutex> lock(mute);
+  m_retired.erase(std::remove_if(m_retired.begin(), m_retired.end(),
+                                 [&](Retired const& r) { return r.generation < oldest; }),
+                  m_retired.end());
+}
+
+YAML::Node maiken::dist::SetupCache::stats() const {
+  YAML::Node node;
+  node["hits"] = hits.load();
+  node["misses"] = misses.load();
+  {
+    std::lock_guard<std::mutex> lock(mute);
+    node["entries"] = m_entries.size();
+  }
+  return node;
+}
+
+kul::http::_1_1Response maiken::dist::Server::stats() {
+  YAML::Node root;
+  root["cache"] = cache.stats();
+  root["setups"] = setups.stats();
+  {
+    std::lock_guard<std::mutex> lock(mute);
+    root["sessions"] = sessions.size();
+  }
+  YAML::Emitter out;
+  out << root;
+  kul::http::_1_1Response r;
+  r.withBody(std::string(out.c_str()));
+  return r.withDefaultHeaders();
+}
 
 kul::http::_1_1Response maiken::dist::Server::respond(const kul::http::A1_1Request& req) {
+  if (req.path() == "/stats" || req.path() == "stats") return stats();
   kul::http::_1_1Response r;
-  // check session exists - if not error
-  if (!sessions.count(req.ip())) {
+  if (!req.header("session")) {
     r.withBody("ruh roh");
     return r.withDefaultHeaders();
   }
@@ -46,7 +345,23 @@ kul::http::_1_1Response maiken::dist::Server::respond(const kul::http::A1_1Reque
     cereal::PortableBinaryInputArchive iarchive(iss);
     iarchive(p);
   }
-  p.message()->do_response_for(req, sessions, r);
+  // only setup or a handshake may start a session, anything else must follow one
+  bool const setup = dynamic_cast<SetupRequest*>(p.message()) != nullptr;
+  bool const status = dynamic_cast<StatusRequest*>(p.message()) != nullptr;
+  auto* sesh = session((*req.headers().find("session")).second, setup || status);
+  if (!sesh) {
+    r.withBody("ruh roh");
+    return r.withDefaultHeaders();
+  }
+  std::unique_ptr<ServerSession, std::function<void(ServerSession*)>> const active(
+      sesh, [this](ServerSession* s) { release(*s); });
+  if (status) {  // not held up by the session's own requests
+    p.message()->do_response_for(req, *sesh, r);
+    return r.withDefaultHeaders();
+  }
+  std::lock_guard<std::mutex> lock(sesh->mute);
+  p.message()->do_response_for(req, *sesh, r);
+  if (setup) p.release();  // owned by the session
   return r.withDefaultHeaders();
 }
 
@@ -0,0 +1,163 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#if defined(_MKN_WITH_MKN_RAM_) && defined(_MKN_WITH_IO_CEREAL_)
+
+#include "maiken/dist.hpp"
+
+#include <array>
+#include <iomanip>
+
+std::string maiken::dist::Store::HASH(uint8_t const* data, size_t const len) {
+  return NAME(PreprocessedUnit::HASH(data, len), len);
+}
+
+std::string maiken::dist::Store::NAME(uint64_t const hash, size_t const len) {
+  std::stringstream ss;
+  ss << std::hex << std::setw(16) << std::setfill('0') << hash << "-" << len;
+  return ss.str();
+}
+
+void maiken::dist::FileWriter::write(Blob::Segment const& segment, uint8_t const* data)
+    KTHROW(kul::Exception) {
+  if (!bw) {
+    file = segment.file;
+    hash = PreprocessedUnit::HASH_SEED;
+    len = 0;
+    kul::File tmp(file + part);
+    if (!tmp.dir()) tmp.dir().mk();
+    bw = std::make_unique<kul::io::BinaryWriter>(tmp);
+  }
+  if (segment.len) {
+    bw->write(data, segment.len);
+    if (verify) hash = PreprocessedUnit::HASH(data, segment.len, hash);
+    len += segment.len;
+  }
+  if (!segment.last) return;
+  bw.reset();
+  kul::File const tmp(file + part), out(file);
+  if (verify) {
+    std::string const name(out.name());
+    if (name.substr(0, name.find('.')) != Store::NAME(hash, len)) {
+      tmp.rm();
+      KEXCEPT(Exception, "Upload does not match its name: ") << name;
+    }
+    if (out) {  // another session uploaded the same content first
+      tmp.rm();
+      return;
+    }
+  }
+  if (out) out.rm();
+  if (std::rename(tmp.full().c_str(), file.c_str()) != 0)
+    KEXCEPT(Exception, "Failed to move downloaded file into place: ") << file;
+}
+
+std::vector<uint8_t> maiken::dist::Store::READ(kul::File const& file) KTHROW(kul::Exception) {
+  std::vector<uint8_t> data;
+  kul::io::BinaryReader br(file);
+  size_t red = 0;
+  uint8_t* buffer = Blob::SCRATCH();
+  while ((red = br.read(buffer, BUFF_SIZE)) > 0) data.insert(data.end(), buffer, buffer + red);
+  return data;
+}
+
+std::vector<std::string> maiken::dist::Store::MISSING(Host const& host,
+                                                      std::vector<std::string> const& blobs)
+    KTHROW(kul::Exception) {
+  Post manifest(RemoteCommandManager::INST().build_manifest_request(blobs));
+  manifest.send(host);
+  YAML::Node const reply = YAML::Load(manifest.body());
+  if (!reply["status"] || reply["status"].Scalar() != "0")
+    KEXCEPT(Exception, "Node rejected manifest: ") << host.host();
+  std::vector<std::string> missing;
+  for (auto const& blob : reply["missing"]) {
+    if (std::find(blobs.begin(), blobs.end(), blob.Scalar()) == blobs.end())
+      KEXCEPT(Exception, "Node requested unknown blob: ") << blob.Scalar();
+    missing.emplace_back(blob.Scalar());
+  }
+  return missing;
+}
+
+void maiken::dist::Store::UPLOAD(Host const& host, std::string const& blob, uint8_t const* data,
+                                 size_t const len) KTHROW(kul::Exception) {
+  size_t sent = 0;
+  do {
+    Blob b;
+    b.segments.resize(1);
+    b.segments[0].file = blob;
+    b.len = b.segments[0].len = std::min(len - sent, BUFF_SIZE / 2);
+    std::memcpy(b.c1, data + sent, b.len);
+    sent += b.len;
+    b.segments[0].last = sent == len;
+    b.files_left = !b.segments[0].last;
+    b.compress(host.compression());
+    std::ostringstream ss(std::ios::out | std::ios::binary);
+    {
+      cereal::PortableBinaryOutputArchive oarchive(ss);
+      oarchive(b);
+    }
+    Post(RemoteCommandManager::INST().build_upload_request(ss.str())).send(host);
+  } while (sent < len);
+}
+
+std::vector<std::pair<size_t, size_t>> maiken::dist::Store::CHUNKS(uint8_t const* data,
+                                                                   size_t const len) {
+  // gear hash, a boundary is where its top bits are zero, around every 64KB
+  static auto const gear = [] {
+    std::array<uint64_t, 256> g;
+    uint64_t x = 0;
+    for (auto& v : g) {  // splitmix64
+      uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      v = z ^ (z >> 31);
+    }
+    return g;
+  }();
+  constexpr size_t MIN = size_t{1} << 14, MAX = size_t{1} << 18;
+  constexpr uint64_t MASK = uint64_t{0xFFFF} << 48;
+
+  std::vector<std::pair<size_t, size_t>> chunks;
+  size_t start = 0;
+  uint64_t h = 0;
+  for (size_t i = 0; i < len; i++) {
+    h = (h << 1) + gear[data[i]];
+    size_t const size = i + 1 - start;
+    if ((size >= MIN && (h & MASK) == 0) || size >= MAX) {
+      chunks.emplace_back(start, size);
+      start = i + 1;
+      h = 0;
+    }
+  }
+  if (start < len || chunks.empty()) chunks.emplace_back(start, len - start);
+  return chunks;
+}
+
+#endif  // _MKN_WITH_MKN_RAM_ && _MKN_WITH_IO_CEREAL_
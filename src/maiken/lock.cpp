@@ -0,0 +1,181 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <fstream>
+#include <iterator>
+
+#include "kul/io.hpp"
+#include "kul/proc.hpp"
+
+#include "maiken/global.hpp"
+#include "maiken/lock.hpp"
+
+std::string maiken::LockFile::KEY(std::string const& project, std::string const& node,
+                                  bool const module) {
+  return project + "\t" + (module ? "1" : "0") + "\t" + node;
+}
+
+std::string maiken::LockFile::EMIT(YAML::Node const& node) {
+  YAML::Emitter out;
+  out << YAML::Flow << node;
+  return out.c_str();
+}
+
+namespace {
+std::string real(std::string const& path) {
+  kul::Dir const d(path);
+  return d ? d.real() : path;
+}
+}  // namespace
+
+std::string maiken::LockFile::relative(std::string const& path) const {
+  std::string const sep(kul::Dir::SEP());
+  auto within = [&](std::string const& base) {
+    return path.size() > base.size() && path.compare(0, base.size(), base) == 0 &&
+           path.compare(base.size(), sep.size(), sep) == 0;
+  };
+  auto const& pks(AppVars::INSTANCE().properkeys());
+  std::string key, base;
+  for (auto const* k : {"MKN_REPO", "MKN_MOD_REPO"}) {
+    auto const it = pks.find(k);
+    if (it == pks.end()) continue;
+    auto const r(real(it->second));
+    if (within(r) && r.size() > base.size()) key = k, base = r;
+  }
+  if (!key.empty()) return "${" + key + "}" + path.substr(base.size());
+  if (path == root) return ".";
+  if (within(root)) return path.substr(root.size() + sep.size());
+  return path;
+}
+
+std::string maiken::LockFile::absolute(std::string const& path) const {
+  if (path.compare(0, 2, "${") == 0) {
+    auto const end = path.find('}');
+    if (end == std::string::npos) return "";
+    auto const& pks(AppVars::INSTANCE().properkeys());
+    auto const it = pks.find(path.substr(2, end - 2));
+    if (it == pks.end()) return "";
+    return real(it->second) + path.substr(end + 1);
+  }
+  if (path == ".") return root;
+  bool const abs = !path.empty() && (path[0] == '/' || path[0] == '\\' ||
+                                     (path.size() > 1 && path[1] == ':'));
+  return abs ? path : kul::Dir::JOIN(root, path);
+}
+
+void maiken::LockFile::load(const kul::Dir& project, bool const update) {
+  kul::File const f("mkn.lock", project);
+  file = f.full();
+  root = project.real();
+  entries.clear();
+  used.clear();
+  if (update || !f) return;
+  try {
+    for (auto const& n : YAML::LoadFile(f.real())["deps"]) {
+      Entry e;
+      e.project = n["project"].Scalar(), e.node = n["node"].Scalar();
+      e.name = n["name"].Scalar(), e.version = n["version"].Scalar();
+      e.commit = n["commit"].Scalar(), e.directory = n["directory"].Scalar();
+      e.profile = n["profile"].Scalar(), e.module = n["module"].as<bool>();
+      e.project = absolute(e.project), e.directory = absolute(e.directory);
+      if (e.project.empty() || e.directory.empty()) continue;
+      entries.emplace(KEY(e.project, e.node, e.module), e);
+    }
+  } catch (const std::exception& e) {
+    KLOG(DBG) << "Ignoring invalid lock file " << file << " : " << e.what();
+    entries.clear();
+  }
+}
+
+maiken::LockFile::Entry const* maiken::LockFile::find(std::string const& project,
+                                                      YAML::Node const& node,
+                                                      bool const module) {
+  if (file.empty()) return nullptr;
+  std::string const key(KEY(project, EMIT(node), module));
+  auto it = entries.find(key);
+  if (it == entries.end() || !kul::Dir(it->second.directory)) return nullptr;
+  return &(used[key] = it->second);
+}
+
+void maiken::LockFile::add(std::string const& project, YAML::Node const& node,
+                           bool const module, std::string const& directory,
+                           std::string const& version) {
+  Entry e;
+  e.project = project, e.node = EMIT(node), e.module = module;
+  e.name = node[STR_NAME] ? node[STR_NAME].Scalar() : "";
+  e.profile = node[STR_PROFILE] ? node[STR_PROFILE].Scalar() : "";
+  e.directory = directory, e.version = version;
+  used[KEY(project, e.node, module)] = e;
+}
+
+void maiken::LockFile::write() const {
+  if (file.empty() || used.empty()) return;
+  // nodes of profiles not set up by this run are kept
+  std::map<std::string, Entry> all(entries.begin(), entries.end());
+  for (auto const& p : used) all[p.first] = p.second;
+  YAML::Node root;
+  for (auto const& p : all) {
+    auto e(p.second);
+    kul::Dir const dir(e.directory);
+    if (!dir) continue;  // never cloned or since removed
+    e.directory = dir.real();
+    auto const it = entries.find(p.first);
+    if (it != entries.end() && it->second.directory == e.directory) e.commit = it->second.commit;
+    if (e.commit.empty() && kul::Dir(dir.join(".git"))) try {
+        kul::Process g("git");
+        kul::ProcessCapture gc(g);
+        g.arg("-C").arg(e.directory).arg("rev-parse").arg("HEAD").start();
+        e.commit = gc.outs();
+        kul::String::TRIM(e.commit);
+      } catch (const kul::Exception& ex) {
+        KLOG(DBG) << "No commit for " << e.directory << " : " << ex.what();
+      }
+    YAML::Node n;
+    n["project"] = relative(e.project);
+    n["name"] = e.name;
+    n["module"] = e.module;
+    n["version"] = e.version;
+    n["commit"] = e.commit;
+    n["directory"] = relative(e.directory);
+    n["profile"] = e.profile;
+    n["node"] = e.node;
+    root["deps"].push_back(n);
+  }
+  YAML::Emitter out;
+  out << root;
+  std::string const content(std::string("# generated by mkn\n") + out.c_str() + "\n");
+  kul::File const f(file);
+  if (f) {
+    std::ifstream in(f.real(), std::ios::binary);
+    std::string const current{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    if (current == content) return;
+  }
+  kul::io::Writer(f) << content;
+}
@@ -31,7 +31,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "maiken.hpp"
 
 void maiken::Application::findObjects(kul::hash::set::String& objects) const {
-  for (auto const& ft : sourceMap()) {
+  auto const sources = sourceMap();
+  for (auto const& ft : *sources) {
     try {
       if (!(*files().find(ft.first)).second.count(STR_COMPILER))
         KEXIT(1, "No compiler found for filetype " + ft.first);
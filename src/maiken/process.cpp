@@ -115,6 +115,7 @@ void maiken::Application::process() KTHROW(kul::Exception) {
     if ((*app)->ig) continue;
     if ((*app)->lang.empty()) (*app)->resolveLang();
     (*app)->main_ = {};
+    (*app)->forgetSourceMap();
     proc_a(**app, !(*app)->srcs.empty());
   }
   if (!this->ig)
@@ -41,70 +41,80 @@ void maiken::Application::resolveProperties() KTHROW(maiken::Exception) {
     if (ps.count(it->first.as<std::string>())) ps.erase(it->first.as<std::string>());
     ps[it->first.as<std::string>()] = s;
   }
+  std::lock_guard<std::mutex> lock(resolved_mute);
+  resolved.clear();
 }
 
-std::shared_ptr<std::tuple<std::string, int, int>> maiken::Properties::KEY(
-    kul::hash::map::S2S const& /*ps*/, std::string const& s) KTHROW(kul::Exception) {
-  std::string r = s;
-  int lb = s.find("${");
-  int clb = s.find("\\${");
-  int rb = s.find("}");
-  int crb = s.find("\\}");
-  while ((lb - clb + 1) == 0) {
-    lb = r.substr(clb + 3).find("${");
-    clb = r.substr(clb + 3).find("\\${");
-  }
-  while ((rb - crb + 1) == 0) {
-    rb = r.substr(crb + 2).find("}");
-    crb = r.substr(crb + 2).find("\\}");
-  }
-  if (lb != -1 && clb == -1 && rb != -1 && crb == -1)
-    return std::make_shared<std::tuple<std::string, int, int>>(r.substr(lb + 2, rb - 2 - lb), lb,
-                                                               rb);
-  return 0;
+// strings with an escaped "\${" or "\}" are left as they are
+std::shared_ptr<maiken::Properties::Template const> maiken::Properties::COMPILE(
+    std::string const& s) {
+  static std::mutex mute;
+  static std::unordered_map<std::string, std::shared_ptr<Template const>> templates;
+  std::lock_guard<std::mutex> lock(mute);
+  auto it = templates.find(s);
+  if (it != templates.end()) return it->second;
+  auto t = std::make_shared<Template>();
+  size_t pos = 0;
+  if (s.find("\\${") == std::string::npos && s.find("\\}") == std::string::npos)
+    for (size_t lb = s.find("${"); lb != std::string::npos; lb = s.find("${", pos)) {
+      size_t const rb = s.find("}", lb + 2);
+      if (rb == std::string::npos) break;
+      t->emplace_back(s.substr(pos, lb - pos));
+      t->emplace_back(s.substr(lb + 2, rb - lb - 2));
+      pos = rb + 1;
+    }
+  t->emplace_back(s.substr(pos));
+  return templates.emplace(s, t).first->second;
 }
 
-std::string maiken::Properties::RESOLVE(Application const& app, std::string const& s)
+// property values are expanded in turn, as they may hold properties themselves
+template <class F>
+std::string maiken::Properties::EXPAND(std::string const& s, F const& value)
     KTHROW(kul::Exception) {
-  std::string r = s;
-  std::shared_ptr<std::tuple<std::string, int, int>> t = KEY(app.properties(), s);
-  if (t) {
-    std::string k = std::get<0>(*t);
-    int const& lb = std::get<1>(*t);
-    int const& rb = std::get<2>(*t);
+  if (s.find("${") == std::string::npos) return s;
+  auto const t(COMPILE(s));
+  if (t->size() == 1) return s;
+  std::string r;
+  r.reserve(s.size());
+  for (size_t i = 0; i < t->size(); i++) r += i % 2 ? EXPAND(value((*t)[i]), value) : (*t)[i];
+  return r;
+}
 
-    if (AppVars::INSTANCE().properkeys().count(k))
-      k = (*AppVars::INSTANCE().properkeys().find(k)).second;
-    else if (app.properties().count(k) == 0) {
-      if (app.project().root()[k] && app.project().root()[k].Type() == 2)
-        k = app.project().root()[k].Scalar();
-      else
-        KEXIT(1, "Property : '" + k + "' has not been defined");
-    } else
-      k = (*app.properties().find(k)).second;
-    r = Properties::RESOLVE(app, r.substr(0, lb) + k + r.substr(rb + 1));
+std::string maiken::Properties::RESOLVE(Application const& app, std::string const& s)
+    KTHROW(kul::Exception) {
+  std::string r;
+  if (s.find("${") == std::string::npos) {
+    r = s;
+    kul::String::TRIM(r);
+    return r;
+  }
+  {
+    std::lock_guard<std::mutex> lock(app.resolved_mute);
+    auto it = app.resolved.find(s);
+    if (it != app.resolved.end()) return it->second;
   }
+  r = EXPAND(s, [&app](std::string const& k) -> std::string {
+    auto const& pks(AppVars::INSTANCE().properkeys());
+    if (pks.count(k)) return (*pks.find(k)).second;
+    if (app.properties().count(k)) return (*app.properties().find(k)).second;
+    if (app.project().root()[k] && app.project().root()[k].Type() == 2)
+      return app.project().root()[k].Scalar();
+    KEXIT(1, "Property : '" + k + "' has not been defined");
+  });
   kul::String::TRIM(r);
+  std::lock_guard<std::mutex> lock(app.resolved_mute);
+  app.resolved[s] = r;
   return r;
 }
 
 std::string maiken::Properties::RESOLVE(const Settings& set, std::string const& s)
     KTHROW(kul::Exception) {
-  std::string r = s;
-  std::shared_ptr<std::tuple<std::string, int, int>> t = KEY(set.properties(), s);
-  if (t) {
-    std::string k = std::get<0>(*t);
-    int const& lb = std::get<1>(*t);
-    int const& rb = std::get<2>(*t);
-
-    if (AppVars::INSTANCE().properkeys().count(k))
-      k = (*AppVars::INSTANCE().properkeys().find(k)).second;
-    else if (set.properties().count(k) > 0)
-      k = (*set.properties().find(k)).second;
-    else
-      KEXIT(1, "Property : '" + k + "' has not been defined");
-    r = Properties::RESOLVE(set, r.substr(0, lb) + k + r.substr(rb + 1));
-  }
+  std::string r = EXPAND(s, [&set](std::string const& k) -> std::string {
+    auto const& pks(AppVars::INSTANCE().properkeys());
+    if (pks.count(k)) return (*pks.find(k)).second;
+    if (set.properties().count(k)) return (*set.properties().find(k)).second;
+    KEXIT(1, "Property : '" + k + "' has not been defined");
+  });
   kul::String::TRIM(r);
   return r;
-}
\ No newline at end of file
+}
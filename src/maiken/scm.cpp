@@ -28,9 +28,27 @@ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
+#include <map>
+
 #include "maiken/scm.hpp"
 #include "maiken/app.hpp"
 #include "maiken/property.hpp"
+#include "maiken/settings.hpp"
+
+namespace {
+// repositories of one remote host updated at once
+constexpr size_t SCM_HOST_THREADS = 4;
+
+// "github.com" for https://github.com/a/b and git@github.com:a/b, empty otherwise
+std::string scm_host(std::string const& url) {
+  auto const scheme = url.find("://");
+  std::string host(scheme == std::string::npos ? url : url.substr(scheme + 3));
+  auto const at = host.find("@");
+  if (at != std::string::npos) host = host.substr(at + 1);
+  auto const end = host.find_first_of(":/");
+  return end == std::string::npos ? "" : host.substr(0, end);
+}
+}  // namespace
 
 class UpdateTracker {
  private:
@@ -59,16 +77,31 @@ void maiken::Application::scmStatus(bool const& deps) KTHROW(kul::scm::Exception
   };
 
   if (deps) add_if_on(this->deps), add_if_on(this->modDeps);
+  v.push_back(this);
 
-  for (auto* app : v) app->scmStatus(0);
-  if (!scm && SCMGetter::HAS(this->project().dir()))
-    scm = SCMGetter::GET(this->project().dir(), this->scr, isMod);
-  auto dir = this->project().dir().real();
-  if (scm && scm->hasChanges(dir)) {
-    std::stringstream branch;
-    branch << " [" << kul::scm::Git{}.branch(project().dir().real()) << "]";
-    KOUT(NON) << project().dir().real() << branch.str();
-    scm->status(dir, /*full =*/0);
+  // repositories are checked at once, reported in order
+  std::vector<uint8_t> changed(v.size(), 0);
+  std::vector<std::string> branches(v.size());
+  kul::ChroncurrentThreadPool<> ctp(kul::cpu::threads(), 1, 1000000000, 1000);
+  for (size_t i = 0; i < v.size(); i++)
+    ctp.async([&v, &changed, &branches, i]() {
+      auto& app(*v[i]);
+      if (!app.scm && SCMGetter::HAS(app.project().dir()))
+        app.scm = SCMGetter::GET(app.project().dir(), app.scr, app.isMod);
+      auto const dir = app.project().dir().real();
+      if (app.scm && app.scm->hasChanges(dir)) {
+        changed[i] = 1;
+        branches[i] = kul::scm::Git{}.branch(dir);
+      }
+    });
+  ctp.finish(10000000);  // 10 milliseconds
+  ctp.rethrow();
+
+  for (size_t i = 0; i < v.size(); i++) {
+    if (!changed[i]) continue;
+    auto const dir = v[i]->project().dir().real();
+    KOUT(NON) << dir << " [" << branches[i] << "]";
+    v[i]->scm->status(dir, /*full =*/0);
     KOUT(NON);
   }
 }
@@ -85,29 +118,18 @@ void maiken::Application::scmUpdate(bool const& f) KTHROW(kul::scm::Exception) {
       KOUT(NON) << "WARNING: ATTEMPTING SCM UPDATE, USER INTERACTION MAY BE "
                    "REQUIRED!";
 
-    std::string const& tscr(
-        !this->scr.empty()
-            ? this->scr
-            : this->project().root()[STR_SCM]
-                  ? Properties::RESOLVE(*this, this->project().root()[STR_SCM].Scalar())
-                  : this->project().root()[STR_NAME].Scalar());
-
-    scmUpdate(f, scm, SCMGetter::REPO(this->project().dir(), tscr, isMod));
+    scmUpdate(f, scm, SCMGetter::REPO(this->project().dir(), scmSource(), isMod));
     UpdateTracker::INSTANCE().add(this->project().dir().real());
   }
 }
 
 void maiken::Application::scmUpdate(bool const& f, const kul::SCM* scm, std::string const& url)
     KTHROW(kul::scm::Exception) {
-  std::string const& ver(!this->scv.empty() ? this->scv
-                                            : this->project().root()[STR_VERSION]
-                                                  ? this->project().root()[STR_VERSION].Scalar()
-                                                  : "");
   bool c = true;
   if (!f) {
     KOUT(NON) << "CHECKING: " << this->project().dir().real() << " FROM " << url;
-    std::string const& lV(scm->localVersion(this->project().dir().real(), ver));
-    std::string const& rV(url.size() ? scm->remoteVersion(url, ver) : "");
+    std::string const& lV(scm->localVersion(this->project().dir().real(), scmVersion()));
+    std::string const& rV(url.size() ? scm->remoteVersion(url, scmVersion()) : "");
     c = lV != rV;
     std::stringstream ss;
     ss << "UPDATE FROM " << url << " VERSION: " << rV << " (Yes/No/1/0)";
@@ -116,14 +138,139 @@ void maiken::Application::scmUpdate(bool const& f, const kul::SCM* scm, std::str
     else
       c = kul::String::BOOL(kul::cli::receive(ss.str()));
   }
-  if (f || c) {
-    std::stringstream ss;
-    if (url.size()) ss << " FROM " << url;
-    KOUT(NON) << "UPDATING: " << this->project().dir().real() << ss.str();
-    scm->up(this->project().dir().real(), url, ver);
-    kul::os::PushDir pushd(this->project().dir());
-    kul::Dir build(".mkn/build");
-    kul::File ts("timestamp", build);
-    if (build && ts) ts.rm();
+  if (!f && !c) return;
+  KOUT(NON) << scmUpdating(url);
+  KOUT(NON) << scmUp(scm, url);
+}
+
+std::string maiken::Application::scmSource() const {
+  if (!this->scr.empty()) return this->scr;
+  if (this->project().root()[STR_SCM])
+    return Properties::RESOLVE(*this, this->project().root()[STR_SCM].Scalar());
+  return this->project().root()[STR_NAME].Scalar();
+}
+
+std::string maiken::Application::scmVersion() const {
+  if (!this->scv.empty()) return this->scv;
+  if (this->project().root()[STR_VERSION]) return this->project().root()[STR_VERSION].Scalar();
+  return "";
+}
+
+std::string maiken::Application::scmUpdating(std::string const& url) const {
+  std::stringstream ss;
+  ss << "UPDATING: " << this->project().dir().real();
+  if (url.size()) ss << " FROM " << url;
+  return ss.str();
+}
+
+std::string maiken::Application::scmUp(const kul::SCM* scm, std::string const& url) const
+    KTHROW(kul::scm::Exception) {
+  std::string const out(SCMGetter::UP(scm, this->project().dir(), url, scmVersion()));
+  kul::File ts("timestamp", kul::Dir(this->project().dir().join(".mkn/build")));
+  if (ts) ts.rm();
+  return out;
+}
+
+// Repositories are updated at once, at most SCM_HOST_THREADS per remote host, and their output
+//  follows in order
+void maiken::Application::SCM_UPDATE(std::vector<Application*> const& apps)
+    KTHROW(kul::scm::Exception) {
+  std::vector<Application*> v;
+  for (auto* app : apps) {
+    size_t i = 0;
+    Application const* p = app;
+    while ((p = p->par)) i++;
+    if (i > AppVars::INSTANCE().dependencyLevel()) continue;
+    auto const& dir(app->project().dir());
+    if (!app->scm && SCMGetter::HAS(dir)) app->scm = SCMGetter::GET(dir, app->scr, app->isMod);
+    if (!app->scm || UpdateTracker::INSTANCE().has(dir.real())) continue;
+    if (std::find(v.begin(), v.end(), app) == v.end()) v.push_back(app);
+  }
+  if (v.empty()) return;
+
+  std::map<std::string, std::vector<size_t>> hosts;
+  std::vector<std::string> sources(v.size()), outs(v.size());
+  for (size_t i = 0; i < v.size(); i++) {
+    sources[i] = v[i]->scmSource();
+    hosts[scm_host(sources[i])].push_back(i);
   }
+  std::vector<std::unique_ptr<kul::ChroncurrentThreadPool<>>> pools;
+  for (auto const& host : hosts) {
+    pools.emplace_back(std::make_unique<kul::ChroncurrentThreadPool<>>(
+        std::min(host.second.size(), SCM_HOST_THREADS), 1, 1000000000, 1000));
+    for (auto const i : host.second)
+      pools.back()->async([&v, &sources, &outs, i]() {
+        auto& app(*v[i]);
+        auto const url(SCMGetter::REPO(app.project().dir(), sources[i], app.isMod));
+        outs[i] = app.scmUpdating(url) + kul::os::EOL() + app.scmUp(app.scm, url);
+      });
+  }
+  for (auto& pool : pools) pool->finish(10000000);  // 10 milliseconds
+  for (auto* app : v) UpdateTracker::INSTANCE().add(app->project().dir().real());
+  for (auto const& out : outs)
+    if (!out.empty()) KOUT(NON) << out;
+  for (auto& pool : pools) pool->rethrow();
+}
+
+// Each repository is mirrored once, with a tarball of every version of it in use, so a machine
+//  given the mirror resolves the same tree without a remote
+void maiken::Application::SCM_MIRROR(std::vector<Application*> const& apps)
+    KTHROW(kul::Exception) {
+  auto const& mirror(Settings::INSTANCE().mirror());
+  if (mirror.empty()) KEXIT(1, "settings.yaml has no local/mirror directory");
+
+  auto git = [](std::vector<std::string> const& args) {
+    kul::Process g("git");
+    kul::ProcessCapture gc(g);
+    for (auto const& a : args) g.arg(a);
+    g.start();
+    return gc.outs();
+  };
+
+  kul::hash::set::String seen;
+  std::vector<std::string> urls;
+  std::map<std::string, std::vector<std::string>> versions;
+  std::vector<Application const*> v;
+  for (auto* app : apps) v.push_back(app);
+  for (size_t i = 0; i < v.size(); i++) {
+    auto const& dir(v[i]->project().dir());
+    if (seen.count(dir.real())) continue;
+    seen.insert(dir.real());
+    for (auto const* dep : v[i]->deps) v.push_back(dep);
+    for (auto const* dep : v[i]->modDeps) v.push_back(dep);
+    if (i < apps.size() || !kul::Dir(dir.join(".git"))) continue;
+    std::string url(git({"-C", dir.real(), "remote", "get-url", "origin"}));
+    kul::String::TRIM(url);
+    if (url.empty()) continue;
+    if (!versions.count(url)) urls.push_back(url);
+    auto& vs(versions[url]);
+    auto const version(v[i]->scmVersion());
+    if (!version.empty() && std::find(vs.begin(), vs.end(), version) == vs.end())
+      vs.push_back(version);
+  }
+
+  std::vector<std::string> outs(urls.size());
+  kul::ChroncurrentThreadPool<> ctp(kul::cpu::threads(), 1, 1000000000, 1000);
+  for (size_t i = 0; i < urls.size(); i++)
+    ctp.async([&, i]() {
+      auto const& url(urls[i]);
+      kul::Dir const bare(kul::Dir::JOIN(mirror, SCMGetter::NAME(url) + ".git"));
+      if (bare)
+        git({"-C", bare.path(), "fetch", "--prune", "origin"});
+      else
+        git({"clone", "--mirror", url, bare.path()});
+      std::stringstream ss;
+      ss << "MIRRORED: " << url;
+      for (auto const& version : versions[url]) {
+        kul::Dir tars(kul::Dir::JOIN(mirror, SCMGetter::NAME(url)), 1);
+        kul::File const tar(SCMGetter::NAME(version) + ".tar.gz", tars);
+        git({"-C", bare.path(), "archive", "--format=tar.gz", "-o", tar.full(), version});
+        ss << " " << version;
+      }
+      outs[i] = ss.str();
+    });
+  ctp.finish(10000000);  // 10 milliseconds
+  for (auto const& out : outs)
+    if (!out.empty()) KOUT(NON) << out;
+  ctp.rethrow();
 }
@@ -0,0 +1,195 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "kul/io.hpp"
+
+#include "maiken/global.hpp"
+#include "maiken/scm.hpp"
+#include "maiken/settings.hpp"
+
+std::string maiken::SCMGetter::NAME(std::string const& repo) {
+  std::string name(repo);
+  for (auto& c : name)
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '-') c = '_';
+  return name;
+}
+
+// A mirror holds <name>.git, a bare mirror of the repository, and <name>/<version>.tar.gz for
+//  each version copied, either is enough
+bool maiken::SCMGetter::MIRRORED(std::string const& repo, std::string const& version) {
+  auto const& mirror(Settings::INSTANCE().mirror());
+  if (mirror.empty()) return false;
+  if (kul::Dir(kul::Dir::JOIN(mirror, NAME(repo) + ".git"))) return true;
+  kul::Dir const tars(kul::Dir::JOIN(mirror, NAME(repo)));
+  if (version.empty()) return tars && !tars.files().empty();
+  return kul::File(NAME(version) + ".tar.gz", tars).is();
+}
+
+// Without a version the SCM clones as it always has. A version is cloned shallow, or without
+//  blobs if it is not a branch or tag, unless the repository was cloned before. The second
+//  clone creates a bare mirror of the repository under ${MKN_REPO}/.mirror and every clone
+//  from then on borrows its objects. Anything in the settings mirror is used before all that.
+std::string maiken::SCMGetter::CO(const kul::SCM* scm, const kul::Dir& d, std::string const& repo,
+                                  std::string const& version) KTHROW(kul::scm::Exception) {
+  // a partial checkout would be taken for the project the next time
+  auto clean = [&]() {
+    try {
+      kul::Dir const partial(d.path());
+      if (partial) partial.rm();
+    } catch (const kul::Exception& e) {
+      KLOG(ERR) << "Failed to remove partial checkout: " << d.path() << " : " << e.what();
+    }
+  };
+  try {
+    return CLONE(scm, d, repo, version);
+  } catch (const kul::scm::Exception& e) {
+    clean();
+    throw;
+  } catch (const std::exception& e) {
+    clean();
+    KEXCEPT(kul::scm::Exception, "SCM checkout failed for: " + d.path() + "\n" + e.what());
+  }
+}
+
+std::string maiken::SCMGetter::CLONE(const kul::SCM* scm, const kul::Dir& d,
+                                     std::string const& repo, std::string const& version)
+    KTHROW(kul::Exception) {
+  std::stringstream out;
+  auto git = [&out](std::vector<std::string> const& args) {
+    kul::Process g("git");
+    kul::ProcessCapture gc(g);
+    for (auto const& a : args) g.arg(a);
+    g.start();
+    out << gc.outs() << gc.errs();
+  };
+
+#ifndef _MKN_DISABLE_GIT_
+  if (MIRRORED(repo, version) && scm == &kul::scm::Manager::INSTANCE().get("git")) {
+    auto const& local(Settings::INSTANCE().mirror());
+    kul::Dir const bare(kul::Dir::JOIN(local, NAME(repo) + ".git"));
+    if (bare) {
+      if (version.empty())
+        git({"clone", bare.path(), d.path()});
+      else {
+        git({"clone", "--no-checkout", bare.path(), d.path()});
+        git({"-C", d.path(), "checkout", version});
+      }
+      git({"-C", d.path(), "remote", "set-url", "origin", repo});
+      return out.str();
+    }
+    if (!version.empty()) {
+      kul::Dir dir(d.path(), 1);
+      kul::Process t("tar");
+      kul::ProcessCapture tc(t);
+      t.arg("-xzf")
+          .arg(kul::File(NAME(version) + ".tar.gz", kul::Dir::JOIN(local, NAME(repo))).real())
+          .arg("-C")
+          .arg(dir.real());
+      t.start();
+      return tc.outs() + tc.errs();
+    }
+  }
+#endif  //_MKN_DISABLE_GIT_
+
+#ifndef _MKN_DISABLE_GIT_
+  auto const& pks(AppVars::INSTANCE().properkeys());
+  if (!_MKN_SCM_SHALLOW_ || version.empty() || !pks.count("MKN_REPO") ||
+      scm != &kul::scm::Manager::INSTANCE().get("git"))
+#endif  //_MKN_DISABLE_GIT_
+    return scm->co(d.path(), repo, version);
+
+  std::string const name(NAME(repo));
+  kul::Dir mirrors(kul::Dir::JOIN((*pks.find("MKN_REPO")).second, ".mirror"));
+  kul::Dir const mirror(mirrors.join(name + ".git"));
+  kul::File cloned(name, mirrors);
+  // a version the mirror has needs no fetch, the clone takes anything newer from "repo"
+  auto has = [&version](kul::Dir const& m) {
+    kul::Process g("git");
+    kul::ProcessCapture gc(g);
+    g.arg("-C").arg(m.path()).arg("rev-parse").arg("--verify").arg("--quiet");
+    g.arg(version + "^{commit}");
+    try {
+      g.start();
+    } catch (const kul::proc::ExitException& e) {
+      return false;
+    }
+    return true;
+  };
+  if (!mirror || !has(mirror)) {
+    std::lock_guard<std::mutex> lock(INSTANCE().mirror_mute);
+    if (mirror) {
+      // another clone may have fetched it meanwhile
+      if (!has(mirror)) git({"-C", mirror.path(), "fetch", "--prune", "origin"});
+    } else if (cloned) {
+      git({"clone", "--mirror", repo, mirror.path()});
+      cloned.rm();
+    }
+  }
+  if (mirror) {
+    git({"clone", "--no-checkout", "--reference", mirror.path(), repo, d.path()});
+    git({"-C", d.path(), "checkout", version});
+    return out.str();
+  }
+
+  try {
+    git({"clone", "--depth", "1", "--branch", version, repo, d.path()});
+  } catch (const kul::proc::ExitException& e) {
+    // versions that are commits cannot be fetched shallow by name
+    kul::Dir partial(d.path());
+    if (partial) partial.rm();
+    git({"clone", "--filter=blob:none", "--no-checkout", repo, d.path()});
+    git({"-C", d.path(), "checkout", version});
+  }
+  if (!mirrors) mirrors.mk();
+  kul::io::Writer(cloned) << repo;
+  return out.str();
+}
+
+// git output is returned rather than printed so updates running at once do not interleave
+std::string maiken::SCMGetter::UP(const kul::SCM* scm, const kul::Dir& d, std::string const& repo,
+                                  std::string const& version) KTHROW(kul::scm::Exception) {
+#ifndef _MKN_DISABLE_GIT_
+  if (scm == &kul::scm::Manager::INSTANCE().get("git")) {
+    kul::Process g("git");
+    kul::ProcessCapture gc(g);
+    g.arg("-C").arg(d.real()).arg("pull");
+    if (!repo.empty()) g.arg(repo);
+    if (!version.empty()) g.arg(version);
+    try {
+      g.start();
+    } catch (const kul::proc::ExitException& e) {
+      KEXCEPT(kul::scm::Exception, "SCM update failed for: " + d.real() + "\n" + gc.errs());
+    }
+    return gc.outs() + gc.errs();
+  }
+#endif  //_MKN_DISABLE_GIT_
+  scm->up(d.real(), repo, version);
+  return "";
+}
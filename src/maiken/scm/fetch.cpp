@@ -0,0 +1,178 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "maiken/app.hpp"
+#include "maiken/scm.hpp"
+
+void maiken::SCMFetcher::fetch(const kul::Dir& d, std::string const& scr,
+                               std::string const& version, bool module,
+                               std::string const& profiles) {
+#ifndef _MKN_DISABLE_SCM_
+  std::lock_guard<std::mutex> lock(mute);
+  if (states.count(d.path()) || d.is()) return;
+  states[d.path()] = State::QUEUED;
+  running++;
+  if (!pool)
+    pool = std::make_unique<kul::ChroncurrentThreadPool<>>(kul::cpu::threads(), 1, 1000000000,
+                                                           1000);
+  pool->async([this, d, scr, version, module, profiles]() {
+    clone(d, scr, version, module, profiles);
+  });
+#endif  //_MKN_DISABLE_SCM_
+}
+
+bool maiken::SCMFetcher::wait(const kul::Dir& d) {
+  std::unique_lock<std::mutex> lock(mute);
+  auto it = states.find(d.path());
+  if (it == states.end()) return false;
+  auto& state(it->second);
+  cv.wait(lock, [&] { return state != State::QUEUED; });
+  if (state != State::CLONED) return false;
+  state = State::CLAIMED;
+  std::string output(std::move(outputs[d.path()]));
+  outputs.erase(d.path());
+  lock.unlock();
+  while (!output.empty() && (output.back() == '\n' || output.back() == '\r')) output.pop_back();
+  KOUT(NON) << output;
+  return true;
+}
+
+std::string maiken::SCMFetcher::DIRECTORY(std::string name, std::string version, bool module) {
+  auto const& pks(AppVars::INSTANCE().properkeys());
+  auto const repo(pks.find(module ? "MKN_MOD_REPO" : "MKN_REPO"));
+  if (repo == pks.end()) return "";
+  if (_MKN_REP_VERS_DOT_) kul::String::REPLACE_ALL(version, ".", kul::Dir::SEP());
+  if (_MKN_REP_NAME_DOT_) kul::String::REPLACE_ALL(name, ".", kul::Dir::SEP());
+  return kul::Dir::JOIN((*repo).second, kul::Dir::JOIN(name, version));
+}
+
+void maiken::SCMFetcher::finish() {
+  std::unique_ptr<kul::ChroncurrentThreadPool<>> p;
+  {
+    std::unique_lock<std::mutex> lock(mute);
+    cv.wait(lock, [&] { return running == 0; });
+    p = std::move(pool);
+  }
+  if (p) p->finish(10000000);  // 10 milliseconds
+}
+
+void maiken::SCMFetcher::clone(kul::Dir d, std::string const scr, std::string const version,
+                               bool module, std::string const profiles) {
+  bool cloned = 0;
+  // printed by "wait", clones running at once would interleave
+  std::stringstream out;
+  try {
+    out << MKN_PROJECT_NOT_FOUND << d << kul::os::EOL();
+    if (auto const* scm = SCMGetter::GET(d, scr, module)) {
+      out << SCMGetter::CO(scm, d, SCMGetter::REPO(d, scr, module), version);
+      cloned = d.is();
+    }
+  } catch (const kul::Exception& e) {
+    KLOG(DBG) << "Clone failed for " << d << " : " << e.what();
+  } catch (...) {
+    KLOG(DBG) << "Clone failed for " << d;
+  }
+  // setup clones it again and reports the error
+  if (!cloned && d.is()) d.rm();
+  if (cloned) try {
+      discover(d, profiles);
+    } catch (const std::exception& e) {
+      KLOG(DBG) << "Dependencies not discovered for " << d << " : " << e.what();
+    }
+  {
+    std::lock_guard<std::mutex> lock(mute);
+    states[d.path()] = cloned ? State::CLONED : State::FAILED;
+    if (cloned) outputs[d.path()] = out.str();
+    running--;
+  }
+  cv.notify_all();
+}
+
+// Only dependencies that can be located without resolving properties are queued, everything
+//  else is left to setup
+void maiken::SCMFetcher::discover(const kul::Dir& d, std::string const& profiles) {
+  kul::File yml("mkn.yaml", d);
+  if (!yml && kul::File("mkn.yml", d).is()) yml = kul::File("mkn.yml", d);
+  if (!yml) return;
+  YAML::Node const root(YAML::LoadFile(yml.real()));
+  auto unresolved = [](std::string const& s) { return s.find("${") != std::string::npos; };
+  auto queue = [&](std::string scr, std::string name, std::string const& version,
+                   std::string const& pros, bool module) {
+    if (name.empty() || version.empty()) return;
+    if (unresolved(scr) || unresolved(name) || unresolved(version) || unresolved(pros)) return;
+    std::string const dep(DIRECTORY(name, version, module));
+    if (!dep.empty()) fetch(kul::Dir(dep), scr, version, module, pros);
+  };
+  auto queue_node = [&](YAML::Node const& n, bool module) {
+    if (n[STR_LOCAL] || !n[STR_NAME]) return;
+    std::string const name(n[STR_NAME].Scalar());
+    queue(n[STR_SCM] ? n[STR_SCM].Scalar() : name, name,
+          n[STR_VERSION] ? n[STR_VERSION].Scalar() : "",
+          n[STR_PROFILE] ? n[STR_PROFILE].Scalar() : "", module);
+  };
+  // "scm/name[profiles]#version" as accepted by -w
+  auto queue_string = [&](std::string with) {
+    if (with.find_first_of("(){}&") != std::string::npos) return;
+    std::string pros, version;
+    auto const ha = with.find("#");
+    if (ha != std::string::npos) version = with.substr(ha + 1), with = with.substr(0, ha);
+    auto const lb = with.find("["), rb = with.find("]");
+    if (lb != std::string::npos) {
+      if (rb == std::string::npos || rb < lb) return;
+      pros = with.substr(lb + 1, rb - lb - 1), with = with.substr(0, lb);
+      kul::String::REPLACE_ALL(pros, ",", " ");
+    }
+    if (with.empty()) return;
+    queue(with, kul::String::SPLIT(with, "/").back(), version, pros, 0);
+  };
+
+  std::vector<std::string> chain{kul::String::SPLIT(profiles, ' ')};
+  if (chain.empty()) chain.emplace_back("");
+  for (auto profile : chain) {
+    if (profile.empty() || profile == "@") profile = root[STR_NAME].Scalar();
+    for (size_t i = 0; !profile.empty() && i <= root[STR_PROFILE].size(); i++) {
+      bool found = root[STR_NAME].Scalar() == profile;
+      YAML::Node n;
+      if (found) n = root;
+      for (auto const& node : root[STR_PROFILE])
+        if (!found && node[STR_NAME].Scalar() == profile) n = node, found = 1;
+      if (!found) break;
+      if (n[STR_DEP] && n[STR_DEP].IsScalar())
+        for (auto const& with : kul::cli::asArgs(n[STR_DEP].Scalar())) queue_string(with);
+      else if (n[STR_DEP] && n[STR_DEP].IsSequence())
+        for (auto const& dep : n[STR_DEP]) queue_node(dep, 0);
+      if (n[STR_MOD] && n[STR_MOD].IsSequence())
+        for (auto const& mod : n[STR_MOD])
+          if (mod.IsMap()) queue_node(mod, 1);
+      profile = n[STR_PARENT] ? n[STR_PARENT].Scalar() : "";
+      if (unresolved(profile)) break;
+    }
+  }
+}
@@ -28,10 +28,94 @@ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
+#include "kul/io.hpp"
+#include "kul/time.hpp"
+
 #include "maiken/except.hpp"
 #include "maiken/scm.hpp"
 #include "maiken/settings.hpp"
 
+maiken::SCMGetter::SCMGetter() : file("remotes", kul::user::home(STR_MAIKEN)) {
+  if (!file) return;
+  kul::io::Reader r(file);
+  char const* c = 0;
+  while ((c = r.readLine())) {
+    auto bits = kul::String::SPLIT(std::string(c), '\t');
+    try {
+      if (bits.size() == 3)
+        lookups[bits[0]] = std::make_pair(bits[1] == "1", kul::String::UINT64(bits[2]));
+    } catch (const kul::StringException& e) {
+      KLOG(DBG) << "Ignoring invalid remotes cache line: " << c;
+    }
+  }
+}
+
+void maiken::SCMGetter::write(uint64_t const now, uint64_t const ttl) const {
+  if (!file.dir()) file.dir().mk();
+  kul::io::Writer w(file);
+  for (auto const& p : lookups)
+    if (now - p.second.second < ttl)
+      w << p.first << "\t" << (p.second.first ? "1" : "0") << "\t" << p.second.second
+        << kul::os::EOL();
+}
+
+bool maiken::SCMGetter::LS_REMOTE(std::string const& repo) {
+  try {
+    kul::Process g("git");
+    kul::ProcessCapture gp(g);
+    std::string r1(repo);
+    if (repo.find("http") != std::string::npos && repo.find("@") == std::string::npos)
+      r1 = repo.substr(0, repo.find("//") + 2) + "u:p@" + repo.substr(repo.find("//") + 2);
+    g.arg("ls-remote").arg(r1);
+    g.start();
+    auto errs(gp.errs());
+    kul::String::TRIM(errs);
+    auto lines(kul::String::LINES(errs));
+    if (errs.empty()) lines.clear();
+    bool allwarn = true;
+    for (auto const& line : lines)
+      if (line.find("warning") == std::string::npos) allwarn = false;
+    if (lines.empty() || (lines.size() && allwarn)) return true;
+    KLOG(DBG) << gp.outs();
+    KLOG(DBG) << gp.errs();
+  } catch (const kul::proc::ExitException& e) {
+    KLOG(ERR) << e.stack();
+  }
+  return false;
+}
+
+// Mirrored candidates need no lookup. Remembered lookups answer while every earlier candidate is
+//  known not to exist, otherwise all candidates are looked up at once and the first that exists
+//  wins
+std::string maiken::SCMGetter::lookup(std::vector<std::string> const& repos) {
+  if (repos.empty()) return "";
+  for (auto const& repo : repos)
+    if (MIRRORED(repo)) return repo;
+  uint64_t const now = kul::Now::MILLIS() / 1000, ttl = Settings::INSTANCE().remoteTTL();
+  {
+    std::lock_guard<std::mutex> lock(mute);
+    for (auto const& repo : repos) {
+      auto it = lookups.find(repo);
+      if (!ttl || it == lookups.end() || now - it->second.second >= ttl) break;
+      if (it->second.first) return repo;
+    }
+  }
+  std::vector<uint8_t> exists(repos.size(), 0);
+  kul::ChroncurrentThreadPool<> ctp(repos.size(), 1, 1000000000, 1000);
+  for (size_t i = 0; i < repos.size(); i++)
+    ctp.async([&exists, &repos, i]() { exists[i] = LS_REMOTE(repos[i]); });
+  ctp.finish(10000000);  // 10 milliseconds
+  ctp.rethrow();
+  std::string found;
+  std::lock_guard<std::mutex> lock(mute);
+  for (size_t i = 0; i < repos.size(); i++) {
+    lookups[repos[i]] = std::make_pair(exists[i] != 0, now);
+    if (found.empty() && exists[i]) found = repos[i];
+  }
+  if (ttl) write(now, ttl);
+  return found;
+}
+
 const kul::SCM* maiken::SCMGetter::GET_SCM(const kul::Dir& d, std::string const& r, bool module) {
   std::vector<std::string> repos;
   if (IS_SOLID(r))
@@ -41,46 +125,26 @@ const kul::SCM* maiken::SCMGetter::GET_SCM(const kul::Dir& d, std::string const&
   else
     for (std::string const& s : Settings::INSTANCE().remoteRepos()) repos.push_back(s + r);
 #ifndef _MKN_DISABLE_SCM_
-  for (auto const& repo : repos) {
 #ifndef _MKN_DISABLE_GIT_
-    try {
-      kul::Process g("git");
-      kul::ProcessCapture gp(g);
-      std::string r1(repo);
-      if (repo.find("http") != std::string::npos && repo.find("@") == std::string::npos)
-        r1 = repo.substr(0, repo.find("//") + 2) + "u:p@" + repo.substr(repo.find("//") + 2);
-      g.arg("ls-remote").arg(r1);
-      g.start();
-      auto errs(gp.errs());
-      kul::String::TRIM(errs);
-      auto lines(kul::String::LINES(errs));
-      if (errs.empty()) lines.clear();
-      bool allwarn = true;
-      for (auto const& line : lines)
-        if (line.find("warning") == std::string::npos) allwarn = false;
-      if (lines.empty() || (lines.size() && allwarn)) {
-        INSTANCE().valids.insert(d.path(), repo);
-        return &kul::scm::Manager::INSTANCE().get("git");
-      }
-      KLOG(DBG) << gp.outs();
-      KLOG(DBG) << gp.errs();
-    } catch (const kul::proc::ExitException& e) {
-      KLOG(ERR) << e.stack();
-    }
-#endif  //_MKN_DISABLE_GIT_
-        // SVN NOT YET SUPPORTED
-        // #ifndef _MKN_DISABLE_SVN_
-        //                 try{
-        //                    kul::Process s("svn");
-        //                    kul::ProcessCapture sp(s);
-        //                    s.arg("ls").arg(repo).start();
-        //                    if(!sp.errs().size()) {
-        //                        INSTANCE().valids.insert(d.path(), repo);
-    //                        return &kul::scm::Manager::INSTANCE().get("svn");
-    //                    }
-    //                 }catch(const kul::proc::ExitException& e){}
-    // #endif//_MKN_DISABLE_SVN_
+  std::string const repo(INSTANCE().lookup(repos));
+  if (!repo.empty()) {
+    std::lock_guard<std::mutex> lock(INSTANCE().mute);
+    INSTANCE().valids.insert(d.path(), repo);
+    return &kul::scm::Manager::INSTANCE().get("git");
   }
+#endif  //_MKN_DISABLE_GIT_
+  // SVN NOT YET SUPPORTED
+  // #ifndef _MKN_DISABLE_SVN_
+  //                 try{
+  //                    kul::Process s("svn");
+  //                    kul::ProcessCapture sp(s);
+  //                    s.arg("ls").arg(repo).start();
+  //                    if(!sp.errs().size()) {
+  //                        INSTANCE().valids.insert(d.path(), repo);
+  //                        return &kul::scm::Manager::INSTANCE().get("svn");
+  //                    }
+  //                 }catch(const kul::proc::ExitException& e){}
+  // #endif//_MKN_DISABLE_SVN_
 #else
   KEXIT(1,
         "SCM disabled, cannot resolve dependency, check local paths and "
@@ -97,19 +161,25 @@ bool maiken::SCMGetter::IS_SOLID(std::string const& r) {
 }
 
 std::string maiken::SCMGetter::REPO(const kul::Dir& d, std::string const& r, bool module) {
-  if (INSTANCE().valids.count(d.path())) return INSTANCE().valids.at(d.path());
-  if (IS_SOLID(r))
-    INSTANCE().valids.insert(d.path(), r);
-  else
-    GET_SCM(d, r, module);
-  if (INSTANCE().valids.count(d.path())) return INSTANCE().valids.at(d.path());
+  auto& valids(INSTANCE().valids);
+  {
+    std::lock_guard<std::mutex> lock(INSTANCE().mute);
+    if (valids.count(d.path())) return valids.at(d.path());
+    if (IS_SOLID(r)) valids.insert(d.path(), r);
+  }
+  if (!IS_SOLID(r)) GET_SCM(d, r, module);
+  std::lock_guard<std::mutex> lock(INSTANCE().mute);
+  if (valids.count(d.path())) return valids.at(d.path());
   KEXCEPT(Exception, "SCM not discovered for project: " + d.path());
 }
 bool maiken::SCMGetter::HAS(const kul::Dir& d) {
   return (kul::Dir(d.join(".git")) || kul::Dir(d.join(".svn")));
 }
 const kul::SCM* maiken::SCMGetter::GET(const kul::Dir& d, std::string const& r, bool module) {
-  if (IS_SOLID(r)) INSTANCE().valids.insert(d.path(), r);
+  if (IS_SOLID(r)) {
+    std::lock_guard<std::mutex> lock(INSTANCE().mute);
+    INSTANCE().valids.insert(d.path(), r);
+  }
   if (kul::Dir(d.join(".git"))) return &kul::scm::Manager::INSTANCE().get("git");
   if (kul::Dir(d.join(".svn"))) return &kul::scm::Manager::INSTANCE().get("svn");
   return r.size() ? GET_SCM(d, r, module) : 0;
@@ -59,7 +59,7 @@ void maiken::Application::setup() KTHROW(kul::Exception) {
   auto getIfMissing = [&](YAML::Node const& n, bool const mod) {
     std::string const& cwd(kul::env::CWD());
     kul::Dir projectDir(resolveDepOrModDirectory(n, mod));
-    if (!projectDir.is()) loadDepOrMod(n, projectDir, mod);
+    if (!projectDir.is()) fetchDepOrMod(n, projectDir, mod);
     kul::env::CWD(cwd);
   };
 
@@ -220,6 +220,7 @@ void maiken::Application::setup() KTHROW(kul::Exception) {
   if (par) {
     if (main_ && lang.empty()) lang = main_->in().substr(main_->in().rfind(".") + 1);
     main_ = {};
+    forgetSourceMap();
   }
 
   if (nm) {
@@ -29,6 +29,7 @@ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "maiken.hpp"
+#include "maiken/toolchain.hpp"
 
 void maiken::Application::showConfig(bool force) {
   if (AppVars::INSTANCE().show() || AppVars::INSTANCE().dryRun()) return;
@@ -48,47 +49,19 @@ void maiken::Application::showConfig(bool force) {
       if (it != evs.end()) path = (*it).toString();
     }
 
+    auto& toolchain(Toolchain::INSTANCE());
+    std::vector<std::pair<char const*, char const*>> const bins{
+        {STR_ARCHIVER, "ARCHIVER: "}, {STR_COMPILER, "COMPILER: "}, {STR_LINKER, "LINKER  : "}};
     for (auto const& c : Settings::INSTANCE().root()[STR_FILE]) {
-      bool a = 0, g = 0, l = 0;
       KOUT(NON) << "TYPE    : " << c[STR_TYPE].Scalar();
-      std::vector<std::string> ps;
-      kul::String::SPLIT(path, kul::env::SEP(), ps);
-      for (auto const& d : ps) {
-        if (a && g && l) break;
-        kul::Dir dir(d);
-        if (!dir) continue;
-        for (auto const& f : dir.files()) {
-          std::string b = (f.name().size() > 3 && f.name().substr(f.name().size() - 4) == ".exe")
-                              ? f.name().substr(0, f.name().size() - 4)
-                              : f.name();
-          if (!a && c[STR_ARCHIVER] && b == kul::String::SPLIT(c[STR_ARCHIVER].Scalar(), " ")[0]) {
-            KOUT(NON) << "ARCHIVER: " << f.full();
-            a = 1;
-            break;
-          }
-        }
-        for (auto const& f : dir.files()) {
-          std::string b = (f.name().size() > 3 && f.name().substr(f.name().size() - 4) == ".exe")
-                              ? f.name().substr(0, f.name().size() - 4)
-                              : f.name();
-          if (!g && c[STR_COMPILER])
-            for (auto const& k : Compilers::INSTANCE().keys())
-              if (b == k) {
-                KOUT(NON) << "COMPILER: " << f.full();
-                g = 1;
-                break;
-              }
-        }
-        for (auto const& f : dir.files()) {
-          std::string b = (f.name().size() > 3 && f.name().substr(f.name().size() - 4) == ".exe")
-                              ? f.name().substr(0, f.name().size() - 4)
-                              : f.name();
-          if (!l && c[STR_LINKER] && b == kul::String::SPLIT(c[STR_LINKER].Scalar(), " ")[0]) {
-            KOUT(NON) << "LINKER  : " << f.full();
-            l = 1;
-            break;
-          }
-        }
+      for (auto const& bin : bins) {
+        if (!c[bin.first]) continue;
+        auto const exe(kul::String::SPLIT(c[bin.first].Scalar(), " ")[0]);
+        std::string const full(toolchain.which(exe, path));
+        if (full.empty()) continue;
+        KOUT(NON) << bin.second << full;
+        if (strcmp(bin.first, STR_COMPILER) == 0 && kul::LogMan::INSTANCE().dbg())
+          KOUT(NON) << "VERSION : " << toolchain.version(full);
       }
     }
     if (kul::LogMan::INSTANCE().dbg()) {
@@ -109,7 +82,9 @@ void maiken::Application::showHelp() {
                                  MKN_DEFS_CLEAN,    MKN_DEFS_COMP,    MKN_DEFS_DBG,
                                  MKN_DEFS_INIT,     MKN_DEFS_LINK,    MKN_DEFS_PACK,
                                  MKN_DEFS_PROFS,    MKN_DEFS_RUN,     MKN_DEFS_INC,
-                                 MKN_DEFS_SRC,      MKN_DEFS_TREE,    "",  //
+                                 MKN_DEFS_SRC,      MKN_DEFS_TREE,    MKN_DEFS_COST,
+                                 MKN_DEFS_MIRROR,
+                                 "",  //
                                  MKN_DEFS_ARG,      MKN_DEFS_ARGS,    MKN_DEFS_ADD,
                                  MKN_DEFS_BINC,     MKN_DEFS_BPATH,   MKN_DEFS_DIRC,
                                  MKN_DEFS_DEPS,     MKN_DEFS_DUMP,    MKN_DEFS_DEBUG,
@@ -122,7 +97,8 @@ void maiken::Application::showHelp() {
                                  MKN_DEFS_SHARED,   MKN_DEFS_THREDS,  MKN_DEFS_WITHOUT,
                                  MKN_DEFS_UPDATE,   MKN_DEFS_FUPDATE, MKN_DEFS_VERSON,
                                  MKN_DEFS_WITH,  //
-                                 MKN_DEFS_WARN,     MKN_DEFS_SETTNGS, "",
+                                 MKN_DEFS_WARN,     MKN_DEFS_SETTNGS, MKN_DEFS_TTRACE,
+                                 "",  //
                                  MKN_DEFS_EXMPL,    MKN_DEFS_EXMPL1,  MKN_DEFS_EXMPL2,
                                  MKN_DEFS_EXMPL3,   MKN_DEFS_EXMPL4,  ""};
   for (auto const& s : ss) KOUT(NON) << s;
@@ -36,6 +36,7 @@ void maiken::Application::addMainLine(std::string const& o) KTHROW(kul::Exceptio
   if (v.size() == 0 || v.size() > 2) KEXIT(1, "main invalid format\n" + project().dir().path());
   kul::File f(Properties::RESOLVE(*this, v.front()));
   main_ = Source(f.real(), v.size() == 2 ? Properties::RESOLVE(*this, v[1]) : "");
+  forgetSourceMap();
 }
 
 void maiken::Application::addSourceLine(std::string const& s) KTHROW(kul::Exception) {
@@ -50,6 +51,7 @@ void maiken::Application::addSourceLine(std::string const& s) KTHROW(kul::Except
       if ((*it).first.args().empty() && !args.empty()) srcs.erase(it);
     }
     srcs.emplace_back(Source(str, args), recurse_dir);
+    forgetSourceMap();
   };
   auto do_resolve = [&](std::string const& str, bool recurse_dir = true, std::string args = "") {
     args = Properties::RESOLVE(*this, args);
@@ -84,47 +86,63 @@ void maiken::Application::addSourceLine(std::string const& s) KTHROW(kul::Except
   }
 }
 
-kul::hash::map::S2T<kul::hash::map::S2T<std::vector<maiken::Source>>>
-maiken::Application::sourceMap() const {
+void maiken::Application::forgetSourceMap() const {
+  std::lock_guard<std::mutex> lock(sm_mute);
+  sm.reset();
+}
+
+// Source directories are listed at once. A file found again has its earlier arguments appended
+//  and moves to the end, found through an index of the files taken rather than a search.
+std::shared_ptr<maiken::Application::SourceMap const> maiken::Application::sourceMap() const {
+  std::lock_guard<std::mutex> lock(sm_mute);
+  if (sm) return sm;
   kul::hash::set::String const iMs = inactiveMains();
-  kul::hash::map::S2T<kul::hash::map::S2T<std::vector<maiken::Source>>> sm;
-
-  auto check_replace = [&](std::string const& src, std::string args,
-                           std::vector<maiken::Source>& v) {
-    auto it = std::find_if(v.begin(), v.end(),
-                           [&](Source const& element) { return element.in() == src; });
-    if (it != v.end()) {
-      args += " " + (*it).args();
-      v.erase(it);
-    }
-    v.emplace_back(src, args);
-    it = std::find_if(v.begin(), v.end(),
-                      [&](Source const& element) { return element.in() == src; });
-  };
 
-  for (auto const& sourceDir : sources()) {
-    std::vector<kul::File> files;
-    std::string in(sourceDir.first.in());
-    kul::Dir d(in);
-    if (d)
-      for (auto const& f : d.files(sourceDir.second)) files.push_back(f);
-    else
-      files.push_back(in);
-    for (kul::File const& file : files) {
+  auto const& dirs(sources());
+  std::vector<std::vector<kul::File>> files(dirs.size());
+  {
+    kul::ChroncurrentThreadPool<> ctp(kul::cpu::threads(), 1, 1000000000, 1000);
+    for (size_t i = 0; i < dirs.size(); i++)
+      ctp.async([&dirs, &files, i]() {
+        std::string in(dirs[i].first.in());
+        kul::Dir d(in);
+        if (d)
+          for (auto const& f : d.files(dirs[i].second)) files[i].push_back(f);
+        else
+          files[i].push_back(in);
+      });
+    ctp.finish(10000000);  // 10 milliseconds
+    ctp.rethrow();
+  }
+
+  // file type, directory and file to arguments, the file taken last for a path is the one kept
+  struct Found {
+    std::string ft, dir, src, args;
+  };
+  std::vector<Found> found;
+  std::unordered_map<std::string, size_t> index;
+  for (size_t i = 0; i < dirs.size(); i++)
+    for (kul::File const& file : files[i]) {
       if (file.name().find(".") == std::string::npos || file.name().substr(0, 1).compare(".") == 0)
         continue;
       std::string const ft = file.name().substr(file.name().rfind(".") + 1);
-      if (fs.count(ft) > 0) {
-        std::string const& rl(file.real());
-        bool a = false;
-        for (std::string const& s : iMs) {
-          a = rl.compare(s) == 0;
-          if (a) break;
-        }
-        if (!a) check_replace(rl, sourceDir.first.args(), sm[ft][file.dir().real()]);
+      if (fs.count(ft) == 0) continue;
+      std::string const& rl(file.real());
+      if (iMs.count(rl)) continue;
+      std::string args(dirs[i].first.args());
+      auto it = index.find(rl);
+      if (it != index.end()) {
+        args += " " + found[it->second].args;
+        found[it->second].src.clear();
       }
+      index[rl] = found.size();
+      found.push_back(Found{ft, file.dir().real(), rl, args});
     }
-  }
+
+  auto built = std::make_shared<SourceMap>();
+  for (auto const& f : found)
+    if (!f.src.empty()) (*built)[f.ft][f.dir].emplace_back(f.src, f.args);
+  sm = built;
   return sm;
 }
 
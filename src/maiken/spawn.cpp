@@ -0,0 +1,243 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "maiken/spawn.hpp"
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+extern char** environ;
+
+namespace {
+bool cloexec_pipe(int fds[2]) {
+#if defined(__linux__)
+  return pipe2(fds, O_CLOEXEC) == 0;
+#else
+  if (pipe(fds) != 0) return false;
+  fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+  return true;
+#endif
+}
+void close_fd(int& fd) {
+  if (fd < 0) return;
+  close(fd);
+  fd = -1;
+}
+}  // namespace
+
+maiken::proc::Spawner::~Spawner() {
+  for (auto& c : children) {
+    close_fd(c.out);
+    close_fd(c.err);
+    if (c.pid > 0) {
+      int status;
+      while (waitpid(c.pid, &status, 0) < 0 && errno == EINTR) {
+      }
+    }
+  }
+}
+
+std::vector<std::string> maiken::proc::Spawner::ENVIRONMENT(
+    std::vector<std::pair<std::string, std::string>> const& overrides) {
+  std::vector<std::string> env;
+  for (char** e = environ; *e; e++) {
+    std::string const s(*e);
+    auto const key(s.substr(0, s.find("=")));
+    if (std::find_if(overrides.begin(), overrides.end(),
+                     [&](auto const& o) { return o.first == key; }) == overrides.end())
+      env.emplace_back(s);
+  }
+  for (auto const& o : overrides) env.emplace_back(o.first + "=" + o.second);
+  return env;
+}
+
+void maiken::proc::Spawner::add(std::vector<std::string> const& argv, std::string const& dir,
+                                std::vector<std::string> const& env, Callback const& cb) {
+  tasks.push_back(Task{argv, dir, env, cb});
+}
+
+void maiken::proc::Spawner::launch(Task& task) {
+  Child child;
+  child.cb = task.cb;
+  child.start = std::chrono::steady_clock::now();
+#ifndef _MKN_SPAWN_CHDIR_
+  if (!task.dir.empty()) {
+    child.res.error = "posix_spawn cannot change directory on this system";
+    child.cb(child.res);
+    return;
+  }
+#endif  // _MKN_SPAWN_CHDIR_
+  if (task.argv.empty()) {
+    child.res.error = "nothing to spawn";
+    child.cb(child.res);
+    return;
+  }
+  int out[2] = {-1, -1}, err[2] = {-1, -1};
+  if (!cloexec_pipe(out) || !cloexec_pipe(err)) {
+    child.res.error = std::string("pipe failed: ") + strerror(errno);
+    for (auto* fd : {&out[0], &out[1], &err[0], &err[1]}) close_fd(*fd);
+    child.cb(child.res);
+    return;
+  }
+
+  posix_spawn_file_actions_t fa;
+  posix_spawn_file_actions_init(&fa);
+  posix_spawn_file_actions_adddup2(&fa, out[1], STDOUT_FILENO);
+  posix_spawn_file_actions_adddup2(&fa, err[1], STDERR_FILENO);
+#ifdef _MKN_SPAWN_CHDIR_
+  if (!task.dir.empty()) posix_spawn_file_actions_addchdir_np(&fa, task.dir.c_str());
+#endif  // _MKN_SPAWN_CHDIR_
+
+  std::vector<char*> argv;
+  for (auto& a : task.argv) argv.push_back(const_cast<char*>(a.c_str()));
+  argv.push_back(nullptr);
+  std::vector<char*> envp;
+  for (auto& e : task.env) envp.push_back(const_cast<char*>(e.c_str()));
+  envp.push_back(nullptr);
+
+  // searched for on the PATH of this process
+  int const rc = posix_spawnp(&child.pid, argv[0], &fa, nullptr, &argv[0],
+                              task.env.empty() ? environ : &envp[0]);
+  posix_spawn_file_actions_destroy(&fa);
+  close_fd(out[1]);
+  close_fd(err[1]);
+  if (rc != 0) {
+    close_fd(out[0]);
+    close_fd(err[0]);
+    child.pid = -1;
+    child.res.error = std::string("posix_spawnp failed: ") + strerror(rc);
+    child.cb(child.res);
+    return;
+  }
+  child.out = out[0];
+  child.err = err[0];
+  children.emplace_back(std::move(child));
+}
+
+void maiken::proc::Spawner::reap(Child& child, std::string const& error) {
+  int status = 0;
+  pid_t r;
+  while ((r = waitpid(child.pid, &status, 0)) < 0 && errno == EINTR) {
+  }
+  if (r < 0)
+    child.res.error = std::string("waitpid failed: ") + strerror(errno);
+  else if (WIFEXITED(status))
+    child.res.status = WEXITSTATUS(status);
+  else if (WIFSIGNALED(status))
+    child.res.status = 128 + WTERMSIG(status);
+  child.pid = -1;
+  // output may be missing, so the child cannot count as a success
+  if (!error.empty()) {
+    child.res.error = error;
+    if (child.res.status == 0) child.res.status = -1;
+  }
+  child.res.ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - child.start)
+                     .count();
+  child.cb(child.res);
+}
+
+void maiken::proc::Spawner::run() {
+  std::vector<pollfd> fds;
+  std::vector<std::pair<size_t, bool>> owners;  // child index, is stderr
+  char buf[4096];
+  while (true) {
+    while (!stopped && !tasks.empty() && children.size() < max) {
+      Task task(std::move(tasks.front()));
+      tasks.pop_front();
+      launch(task);
+    }
+    if (children.empty()) break;
+
+    fds.clear();
+    owners.clear();
+    for (size_t i = 0; i < children.size(); i++) {
+      if (children[i].out >= 0) {
+        fds.push_back(pollfd{children[i].out, POLLIN, 0});
+        owners.emplace_back(i, 0);
+      }
+      if (children[i].err >= 0) {
+        fds.push_back(pollfd{children[i].err, POLLIN, 0});
+        owners.emplace_back(i, 1);
+      }
+    }
+    if (!fds.empty() && poll(&fds[0], fds.size(), -1) < 0) {
+      if (errno == EINTR) continue;
+      return abort(std::string("poll failed: ") + strerror(errno));
+    }
+    for (size_t i = 0; i < fds.size(); i++) {
+      if (!fds[i].revents) continue;
+      auto& child = children[owners[i].first];
+      int& fd = owners[i].second ? child.err : child.out;
+      ssize_t const n = read(fd, buf, sizeof(buf));
+      if (n > 0)
+        (owners[i].second ? child.res.errs : child.res.outs).append(buf, n);
+      else if (n == 0 || errno != EINTR)
+        close_fd(fd);
+    }
+    // both pipes closed means the child is exiting, so waiting here is brief
+    for (size_t i = children.size(); i-- > 0;)
+      if (children[i].out < 0 && children[i].err < 0) {
+        Child done(std::move(children[i]));
+        children.erase(children.begin() + i);
+        reap(done);
+      }
+  }
+}
+
+// every running child is reaped and every queued task fails with "error"
+void maiken::proc::Spawner::abort(std::string const& error) {
+  std::vector<Child> running(std::move(children));
+  children.clear();
+  for (auto& child : running) {
+    close_fd(child.out);
+    close_fd(child.err);
+    reap(child, error);
+  }
+  while (!tasks.empty()) {
+    Task task(std::move(tasks.front()));
+    tasks.pop_front();
+    SpawnResult res;
+    res.error = error;
+    task.cb(res);
+  }
+}
+
+#endif  // _WIN32
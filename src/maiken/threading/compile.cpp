@@ -30,13 +30,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "maiken.hpp"
 
-maiken::CompilationUnit maiken::ThreadingCompiler::compilationUnit(
-    std::pair<maiken::Source, std::string> const& p) const KTHROW(kul::Exception) {
-  std::string const src(p.first.in()), obj(p.second);
-  std::string const& fileType = src.substr(src.rfind(".") + 1);
+maiken::ThreadingCompiler::Template const& maiken::ThreadingCompiler::templateFor(
+    std::string const& fileType) const KTHROW(kul::Exception) {
+  std::lock_guard<std::mutex> lock(mute);
+  auto it = templates.find(fileType);
+  if (it != templates.end()) return it->second;
   if (!(app.files().count(fileType))) KEXCEPTION("NOOOOOOO ") << fileType;
-  std::string const& compiler = (*(*app.files().find(fileType)).second.find(STR_COMPILER)).second;
-  std::string const& base = maiken::Compilers::INSTANCE().base(compiler);
+  Template t;
+  t.compiler = (*(*app.files().find(fileType)).second.find(STR_COMPILER)).second;
+  std::string const& base = maiken::Compilers::INSTANCE().base(t.compiler);
   std::vector<std::string> args;
   if (app.arguments().count(fileType) > 0)
     for (std::string const& o : (*app.arguments().find(fileType)).second)
@@ -48,29 +50,54 @@ maiken::CompilationUnit maiken::ThreadingCompiler::compilationUnit(
   auto compilerFlags = [&args](std::string const& as) {
     for (auto const& s : kul::cli::asArgs(as)) args.push_back(s);
   };
-  if (AppVars::INSTANCE().jargs().count(fileType) > 0)
-    compilerFlags((*AppVars::INSTANCE().jargs().find(fileType)).second);
-  compilerFlags(AppVars::INSTANCE().args());
-  auto comp = Compilers::INSTANCE().get(compiler);
-  compilerFlags(comp->compilerDebug(AppVars::INSTANCE().debug()));
-  compilerFlags(comp->compilerOptimization(AppVars::INSTANCE().optimise()));
-  compilerFlags(comp->compilerWarning(AppVars::INSTANCE().warn()));
-  compilerFlags(p.first.args());
-  return CompilationUnit(app, comp, compiler, args, incs, src, obj, app.m,
-                         AppVars::INSTANCE().dryRun());
+  if (vars.jargs().count(fileType) > 0)
+    compilerFlags((*vars.jargs().find(fileType)).second);
+  compilerFlags(vars.args());
+  t.comp = Compilers::INSTANCE().get(t.compiler);
+  compilerFlags(t.comp->compilerDebug(vars.debug()));
+  compilerFlags(t.comp->compilerOptimization(vars.optimise()));
+  compilerFlags(t.comp->compilerWarning(vars.warn()));
+  if (vars.timeTrace()) compilerFlags(t.comp->compilerTimeTrace());
+  t.args = std::make_shared<std::vector<std::string> const>(std::move(args));
+  return templates.emplace(fileType, std::move(t)).first->second;
+}
+
+maiken::CompilationUnit maiken::ThreadingCompiler::compilationUnit(
+    std::pair<maiken::Source, std::string> const& p) const KTHROW(kul::Exception) {
+  std::string const src(p.first.in()), obj(p.second);
+  auto const& t = templateFor(src.substr(src.rfind(".") + 1));
+  CompilationUnit::Strings args(t.args);
+  if (!p.first.args().empty()) {
+    auto own = std::make_shared<std::vector<std::string>>(*t.args);
+    for (auto const& s : kul::cli::asArgs(p.first.args())) own->push_back(s);
+    args = own;
+  }
+  return CompilationUnit(app, t.comp, t.compiler, args, incs, fincs, src, obj, app.m,
+                         vars.dryRun());
 }
 
 std::string maiken::CompilationUnit::compileString() const KTHROW(kul::Exception) {
-  kul::os::PushDir pushd(app.project().dir());
-  CompileDAO dao{app, compiler, in, out, args, incs, mode, /*dryRun=*/true};
+  CompileDAO dao{app, compiler, in, out, *args, *incs, mode, /*dryRun=*/true, fincs.get()};
+  return comp->compileSource(dao).cmd();
+}
+
+maiken::CompilerProcessCapture maiken::CompilationUnit::preprocess(std::string const& file) const
+    KTHROW(kul::Exception) {
+  CompileDAO dao{app, compiler, in, file, *args, *incs, mode, dryRun, fincs.get(), true};
+  return comp->compileSource(dao);
+}
+
+std::string maiken::CompilationUnit::compileString(std::string const& _in,
+                                                   std::string const& _out) const
+    KTHROW(kul::Exception) {
+  std::vector<std::string> const none;
+  CompileDAO dao{app, compiler, _in, _out, *args, none, mode, /*dryRun=*/true, &none};
   return comp->compileSource(dao).cmd();
 }
 
 maiken::CompilerProcessCapture maiken::CompilationUnit::compile() const KTHROW(kul::Exception) {
   try {
-    kul::os::PushDir pushd(app.project().dir());
-
-    CompileDAO dao{app, compiler, in, out, args, incs, mode, dryRun};
+    CompileDAO dao{app, compiler, in, out, *args, *incs, mode, dryRun, fincs.get()};
 
     return comp->compileSource(dao);
   } catch (const std::exception& e) {
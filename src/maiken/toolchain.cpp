@@ -0,0 +1,147 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <cstdio>
+#include <random>
+
+#include "maiken.hpp"
+#include "maiken/toolchain.hpp"
+
+maiken::Toolchain::Toolchain() : file("toolchain", kul::user::home(STR_MAIKEN)) {
+  if (!file) return;
+  kul::io::Reader r(file);
+  char const* c = 0;
+  while ((c = r.readLine())) {
+    auto bits = kul::String::SPLIT(std::string(c), '\t');
+    try {
+      if (bits.size() == 5 && bits[0] == "which")
+        whiches[bits[1] + "\t" + bits[2]] = std::make_pair(bits[3], kul::String::UINT64(bits[4]));
+      else if (bits.size() == 4 && bits[0] == "version")
+        versions[bits[1]] = std::make_pair(bits[3], kul::String::UINT64(bits[2]));
+    } catch (const kul::StringException& e) {
+      KLOG(DBG) << "Ignoring invalid toolchain cache line: " << c;
+    }
+  }
+}
+
+void maiken::Toolchain::write() {
+  std::lock_guard<std::mutex> lock(mute);
+  if (!dirty) return;
+  dirty = 0;
+  // binaries since removed or replaced are dropped
+  auto const current = [](std::pair<std::string, uint64_t> const& p, std::string const& bin) {
+    kul::File const f(bin);
+    return f && f.timeStamps().modified() == p.second;
+  };
+  try {
+    if (!file.dir()) file.dir().mk();
+    kul::File const tmp(file.name() + "." + std::to_string(std::random_device{}()), file.dir());
+    {
+      kul::io::Writer w(tmp);
+      for (auto const& p : whiches)
+        if (current(p.second, p.second.first))
+          w << "which\t" << p.first << "\t" << p.second.first << "\t" << p.second.second
+            << kul::os::EOL();
+      for (auto const& p : versions)
+        if (current(p.second, p.first))
+          w << "version\t" << p.first << "\t" << p.second.second << "\t" << p.second.first
+            << kul::os::EOL();
+    }
+    if (std::rename(tmp.full().c_str(), file.full().c_str())) {
+      KLOG(ERR) << "Failed to replace toolchain cache: " << file.full();
+      tmp.rm();
+    }
+  } catch (const std::exception& e) {
+    KLOG(ERR) << "Failed to write toolchain cache: " << e.what();
+  }
+}
+
+std::string const& maiken::Toolchain::key(std::string const& path) {
+  if (!keys.count(path)) {
+    // settings can change which compilers are used
+    std::stringstream ss;
+    ss << path << "\t" << Settings::INSTANCE().file();
+    kul::File const settings(Settings::INSTANCE().file());
+    if (settings) ss << "\t" << settings.timeStamps().modified();
+    keys.insert(path, Application::hash(ss.str()));
+  }
+  return keys.at(path);
+}
+
+std::string maiken::Toolchain::which(std::string const& bin, std::string const& path) {
+  std::lock_guard<std::mutex> lock(mute);
+  std::string const k = key(path) + "\t" + bin;
+  auto it = whiches.find(k);
+  if (it != whiches.end()) {
+    if (it->second.first.empty()) return "";  // not found earlier in this run
+    kul::File const f(it->second.first);
+    if (f && f.timeStamps().modified() == it->second.second) return it->second.first;
+  }
+  std::string full;
+  uint64_t mod = 0;
+  for (auto const& d : kul::String::SPLIT(path, kul::env::SEP())) {
+    kul::Dir const dir(d);
+    if (!dir) continue;
+    for (auto const& n : {bin, bin + ".exe"}) {
+      kul::File const f(n, dir);
+      if (!f) continue;
+      full = f.full();
+      mod = f.timeStamps().modified();
+      break;
+    }
+    if (!full.empty()) break;
+  }
+  whiches[k] = std::make_pair(full, mod);
+  if (!full.empty()) dirty = 1;
+  return full;
+}
+
+std::string maiken::Toolchain::version(std::string const& bin) {
+  std::lock_guard<std::mutex> lock(mute);
+  kul::File const f(bin);
+  if (!f) return "";
+  uint64_t const mod = f.timeStamps().modified();
+  std::string const full = f.full();
+  if (versions.count(full) && versions.at(full).second == mod) return versions.at(full).first;
+  std::string v;
+  try {
+    kul::Process p(f.escm());
+    kul::ProcessCapture pc(p);
+    p.arg("--version").start();
+    auto lines = kul::String::LINES(pc.outs().empty() ? pc.errs() : pc.outs());
+    if (!lines.empty()) v = lines[0];
+    kul::String::TRIM(v);
+  } catch (const kul::Exception& e) {
+    KLOG(DBG) << "Version probe failed for " << full << ": " << e.what();
+  }
+  versions[full] = std::make_pair(v, mod);
+  dirty = 1;
+  return v;
+}
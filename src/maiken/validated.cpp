@@ -0,0 +1,121 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+#include "kul/io.hpp"
+
+#include "maiken/app.hpp"
+#include "maiken/validated.hpp"
+
+maiken::Validated::Validated() : file("validated", kul::user::home(STR_MAIKEN)) {
+  if (!file) return;
+  kul::io::Reader r(file);
+  char const* c = 0;
+  while ((c = r.readLine())) {
+    std::string const line(c);
+    auto const tab = line.find('\t');
+    if (tab == std::string::npos)
+      KLOG(DBG) << "Ignoring invalid validated cache line: " << c;
+    else
+      keys[line.substr(0, tab)] = line.substr(tab + 1);
+  }
+}
+
+maiken::Validated::~Validated() {
+  if (!dirty) return;
+  try {
+    if (!file.dir()) file.dir().mk();
+    kul::File const tmp(file.name() + "." + std::to_string(std::random_device{}()), file.dir());
+    {
+      kul::io::Writer w(tmp);
+      for (auto const& p : keys)
+        if (kul::File(p.first)) w << p.first << "\t" << p.second << kul::os::EOL();
+    }
+    if (std::rename(tmp.full().c_str(), file.full().c_str())) {
+      KLOG(ERR) << "Failed to replace validated cache: " << file.real();
+      tmp.rm();
+    }
+  } catch (const std::exception& e) {
+    KLOG(ERR) << "Failed to write validated cache: " << e.what();
+  }
+}
+
+std::string maiken::Validated::STAMP(std::vector<kul::yaml::NodeValidator> const& nodes) {
+  return Application::hash(DESCRIBE(nodes));
+}
+
+std::string maiken::Validated::DESCRIBE(std::vector<kul::yaml::NodeValidator> const& nodes) {
+  std::stringstream ss;
+  for (auto const& n : nodes)
+    ss << n.name() << ":" << n.mandatory() << ":" << static_cast<int>(n.type()) << "{"
+       << DESCRIBE(n.children()) << "}";
+  return ss.str();
+}
+
+namespace {
+std::string size(kul::File const& f) {
+  std::ifstream in(f.real(), std::ios::binary | std::ios::ate);
+  return std::to_string(static_cast<uint64_t>(in.tellg()));
+}
+std::string content(kul::File const& f) {
+  std::ifstream in(f.real(), std::ios::binary);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  return maiken::Application::hash(ss.str());
+}
+}  // namespace
+
+bool maiken::Validated::known(kul::File const& f, std::string const& stamp) {
+  std::string entry;
+  {
+    std::lock_guard<std::mutex> lock(mute);
+    auto it = keys.find(f.real());
+    if (it == keys.end()) return false;
+    entry = it->second;
+  }
+  // stamp, size, mtime, content
+  auto const bits(kul::String::SPLIT(entry, '\t'));
+  if (bits.size() != 4 || bits[0] != stamp || bits[1] != size(f)) return false;
+  if (bits[2] == std::to_string(f.timeStamps().modified())) return true;
+  if (bits[3] != content(f)) return false;
+  add(f, stamp);  // touched but unchanged
+  return true;
+}
+
+void maiken::Validated::add(kul::File const& f, std::string const& stamp) {
+  std::stringstream ss;
+  ss << stamp << "\t" << size(f) << "\t" << f.timeStamps().modified() << "\t" << content(f);
+  std::lock_guard<std::mutex> lock(mute);
+  keys[f.real()] = ss.str();
+  dirty = 1;
+}
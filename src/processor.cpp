@@ -98,11 +98,11 @@ void maiken::Processor::process(std::vector<Application*> apps) {
       app.loadTimeStamps();
 
       SourceFinder s_finder(app);
-      auto sources = app.sourceMap();
-      CompilerValidation::check_compiler_for(app, sources);
+      auto const sources = app.sourceMap();
+      CompilerValidation::check_compiler_for(app, *sources);
       std::vector<kul::File> cacheFiles;
       auto& objects = app_info.at(apP)->objects;
-      for (auto const& pair : s_finder.all_sources_from(sources, objects, cacheFiles)) {
+      for (auto const& pair : s_finder.all_sources_from(*sources, objects, cacheFiles)) {
         auto unit = app_info[apP]->tc.compilationUnit(pair);
         kul::this_thread::nSleep(5000000);  // dup appears to be overloaded with too many threads
         ctp.async(std::bind(lambda, unit), std::bind(lambex, std::placeholders::_1));
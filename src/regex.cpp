@@ -29,8 +29,45 @@ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "maiken/regex.hpp"
+#include <algorithm>
+#include <memory>
+#include <mutex>
 #include <regex>
 #include "kul/log.hpp"
+#include "kul/threads.hpp"
+
+bool maiken::Regexer::FRESH(Listing const& l) {
+  for (auto const& d : l.dirs) {
+    kul::Dir const dir(d.first);
+    if (!dir || dir.timeStamps().modified() != d.second) return false;
+  }
+  return true;
+}
+
+void maiken::Regexer::WALK(kul::Dir const& d, Listing& l) {
+  l.dirs.emplace_back(d.real(), d.timeStamps().modified());
+  for (auto const& f : d.files(0)) l.files.emplace_back(f.real());
+  for (auto const& sub : d.dirs()) WALK(sub, l);
+}
+
+void maiken::Regexer::LIST(kul::Dir const& d, Listing& l) {
+  l = Listing();
+  l.dirs.emplace_back(d.real(), d.timeStamps().modified());
+  for (auto const& f : d.files(0)) l.files.emplace_back(f.real());
+  auto const subs(d.dirs());
+  if (subs.empty()) return;
+  std::vector<Listing> ls(subs.size());
+  kul::ChroncurrentThreadPool<> ctp(std::min(subs.size(), static_cast<size_t>(kul::cpu::threads())),
+                                    1, 1000000000, 1000);
+  for (size_t i = 0; i < subs.size(); i++)
+    ctp.async([&subs, &ls, i]() { WALK(subs[i], ls[i]); });
+  ctp.finish(10000000);  // 10 milliseconds
+  ctp.rethrow();
+  for (auto& sub : ls) {
+    l.files.insert(l.files.end(), sub.files.begin(), sub.files.end());
+    l.dirs.insert(l.dirs.end(), sub.dirs.begin(), sub.dirs.end());
+  }
+}
 
 std::vector<std::string> maiken::Regexer::RESOLVE(std::string str) KTHROW(kul::Exception) {
   std::vector<std::string> v;
@@ -46,21 +83,46 @@ std::vector<std::string> maiken::Regexer::RESOLVE(std::string str) KTHROW(kul::E
 
   if (bits.size() > 1) d = kul::Dir(bits[0]);
   for (size_t i = 1; i < bits.size() - 1; i++) d = d.join(bits[i]);
+  if (!d) return v;
 
-  auto regexer = [&](auto items) {
-    for (auto const& item : items) {
-      try {
-        std::regex re(str);
-        std::smatch match;
-        std::string subject(item.real());
-        if (std::regex_search(subject, match, re) && match.size() > 1) RESOLVE_REC(item.real(), v);
-      } catch (std::regex_error& e) {
-        KEXIT(1, "Regex Failure:\n") << e.what();
-      }
-    }
+  // directories are walked under their own lock, others are resolved meanwhile
+  struct Cached {
+    std::mutex mute;
+    uint64_t used = 0;
+    Listing listing;
   };
-  regexer(d.files(1));
-  return v;
+  static std::mutex mute;
+  static uint64_t uses = 0;
+  static std::unordered_map<std::string, std::shared_ptr<Cached>> listings;
+  std::shared_ptr<Cached> cached;
+  {
+    std::lock_guard<std::mutex> lock(mute);
+    auto& c(listings[d.real()]);
+    if (!c) c = std::make_shared<Cached>();
+    c->used = ++uses;
+    cached = c;
+    if (listings.size() > LISTINGS)
+      listings.erase(std::min_element(listings.begin(), listings.end(), [](auto& a, auto& b) {
+        return a.second->used < b.second->used;
+      }));
+  }
+  std::lock_guard<std::mutex> lock(cached->mute);
+  auto& l(cached->listing);
+  if (l.dirs.empty() || !FRESH(l)) LIST(d, l);
+  if (!l.matches.count(str)) {
+    std::vector<std::string> matches;
+    try {
+      std::regex const re(str, std::regex::ECMAScript | std::regex::optimize);
+      // a match without a group was never taken
+      if (re.mark_count())
+        for (auto const& file : l.files)
+          if (std::regex_search(file, re)) RESOLVE_REC(file, matches);
+    } catch (std::regex_error& e) {
+      KEXIT(1, "Regex Failure:\n") << e.what();
+    }
+    l.matches.emplace(str, std::move(matches));
+  }
+  return l.matches.at(str);
 }
 
 void maiken::Regexer::RESOLVE_REC(std::string const& i, std::vector<std::string>& v)
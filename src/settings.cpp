@@ -61,6 +61,14 @@ maiken::Settings::Settings(std::string const& file_) : kul::yaml::File(file_) {
     if (!d.is() && !d.mk())
       KEXCEPT(SettingsException, "settings.yaml local/mod-repo is not a valid directory");
   }
+  if (root()[STR_LOCAL] && root()[STR_LOCAL][STR_MIRROR]) {
+    std::string m(root()[STR_LOCAL][STR_MIRROR].Scalar());
+    if (m.find("file://") == 0) m = m.substr(7);
+    kul::Dir d(m);
+    if (!d.is() && !d.mk())
+      KEXCEPT(SettingsException, "settings.yaml local/mirror is not a valid directory");
+    mir = d.real();
+  }
   if (root()[STR_REMOTE] && root()[STR_REMOTE][STR_REPO])
     for (auto const& s : kul::String::SPLIT(root()[STR_REMOTE][STR_REPO].Scalar(), ' '))
       rrs.push_back(s);
@@ -69,6 +77,12 @@ maiken::Settings::Settings(std::string const& file_) : kul::yaml::File(file_) {
     for (auto const& s : kul::String::SPLIT(rr, ' ')) rrs.push_back(s);
   }
 
+  if (root()[STR_REMOTE] && root()[STR_REMOTE][STR_TTL]) try {
+      rttl = kul::String::UINT64(root()[STR_REMOTE][STR_TTL].Scalar());
+    } catch (const kul::StringException& e) {
+      KEXCEPT(SettingsException, "settings.yaml remote/ttl is not a valid number of seconds");
+    }
+
   if (root()[STR_REMOTE] && root()[STR_REMOTE][STR_MOD_REPO])
     for (auto const& s : kul::String::SPLIT(root()[STR_REMOTE][STR_MOD_REPO].Scalar(), ' '))
       rms.push_back(s);
@@ -83,7 +97,7 @@ maiken::Settings::Settings(std::string const& file_) : kul::yaml::File(file_) {
     if (f.real() == kul::File(file()).real())
       KEXCEPT(SettingsException, "super cannot reference itself\n" + file());
     SuperSettings::INSTANCE().cycleCheck(f.real());
-    sup = std::make_unique<Settings>(kul::yaml::File::CREATE<Settings>(f.full()));
+    sup = CREATE(f.full());
     for (auto const& p : sup->properties())
       if (!ps.count(p.first)) ps.insert(p.first, p.second);
   }
@@ -96,6 +110,17 @@ maiken::Settings::Settings(std::string const& file_) : kul::yaml::File(file_) {
   resolveProperties();
 }
 
+std::unique_ptr<maiken::Settings> maiken::Settings::CREATE(std::string const& file)
+    KTHROW(SettingsException) {
+  auto settings = std::make_unique<Settings>(file);
+  try {
+    Validated::INSTANCE().validate(*settings);
+  } catch (const kul::yaml::Exception& e) {
+    KEXCEPT(SettingsException, "YAML error encountered in file: " + file + "\n" + e.what());
+  }
+  return settings;
+}
+
 maiken::Settings& maiken::Settings::INSTANCE() KTHROW(kul::Exit) {
   if (!instance.get()) {
     kul::File const f("settings.yaml", kul::user::home("maiken"));
@@ -103,7 +128,7 @@ maiken::Settings& maiken::Settings::INSTANCE() KTHROW(kul::Exit) {
     if (!f.is()) {
       write(f);
     }
-    instance = std::make_unique<Settings>(kul::yaml::File::CREATE<Settings>(f.full()));
+    instance = CREATE(f.full());
   }
   return *instance.get();
 }
@@ -134,7 +159,7 @@ std::string maiken::Settings::RESOLVE(std::string const& s) KTHROW(SettingsExcep
 bool maiken::Settings::SET(std::string const& s) {
   std::string file(RESOLVE(s));
   if (file.size()) {
-    instance = std::make_unique<Settings>(kul::yaml::File::CREATE<Settings>(file));
+    instance = CREATE(file);
     return 1;
   }
   return 0;
@@ -151,9 +176,11 @@ const kul::yaml::Validator maiken::Settings::validator() const {
     NodeValidator("super"), NodeValidator("property", {NodeValidator("*")}, 0, NodeType::MAP),
         NodeValidator("inc"), NodeValidator("path"),
         NodeValidator("local",
-                      {NodeValidator("repo"), NodeValidator("mod-repo"), NodeValidator("debugger")},
+                      {NodeValidator("repo"), NodeValidator("mod-repo"), NodeValidator("debugger"),
+                       NodeValidator("mirror")},
                       0, NodeType::MAP),
-        NodeValidator("remote", {NodeValidator("repo"), NodeValidator("mod-repo")}, 0,
+        NodeValidator("remote",
+                      {NodeValidator("repo"), NodeValidator("mod-repo"), NodeValidator("ttl")}, 0,
                       NodeType::MAP),
         NodeValidator("env",
                       {NodeValidator("name", 1), NodeValidator("value", 1), NodeValidator("mode")},
@@ -164,10 +191,12 @@ const kul::yaml::Validator maiken::Settings::validator() const {
                       1, NodeType::LIST),
 #if defined(_MKN_WITH_MKN_RAM_) && defined(_MKN_WITH_IO_CEREAL_)
         NodeValidator("dist",
-                      {NodeValidator("port"),
+                      {NodeValidator("port"), NodeValidator("compress"),
                        NodeValidator("nodes",
                                      {NodeValidator("host", 1), NodeValidator("port", 1),
-                                      NodeValidator("user"), NodeValidator("pass")},
+                                      NodeValidator("threads"), NodeValidator("preprocess"),
+                                      NodeValidator("user"),
+                                      NodeValidator("pass")},
                                      0, NodeType::LIST)},
                       0, NodeType::MAP),
 #endif  // _MKN_WITH_MKN_RAM_ && _MKN_WITH_IO_CEREAL_
@@ -0,0 +1,121 @@
+/**
+Copyright (c) 2020, Philip Deegan.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the
+distribution.
+    * Neither the name of Philip Deegan nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "maiken/dist.hpp"
+
+#include <iostream>
+
+// Round trips of the dist payload codec, exits non zero on the first failure
+namespace {
+using maiken::dist::Codec;
+
+bool failed(std::string const& what) {
+  std::cerr << "FAILED: " << what << std::endl;
+  return true;
+}
+
+bool throws(std::vector<uint8_t> const& in, size_t const out_len) {
+  std::vector<uint8_t> out(out_len + 1);
+  try {
+    Codec::DECOMPRESS(in.data(), in.size(), out.data(), out_len);
+  } catch (const kul::Exception& e) {
+    return true;
+  }
+  return false;
+}
+
+// compressed at "level", empty if it was not smaller
+std::vector<uint8_t> compress(std::vector<uint8_t> const& in, uint16_t const level) {
+  std::vector<uint8_t> out(in.size() + 1);
+  out.resize(Codec::COMPRESS(level, in.data(), in.size(), out.data()));
+  return out;
+}
+
+bool round_trip(std::string const& name, std::vector<uint8_t> const& in, bool const shrinks) {
+  for (uint16_t level = 1; level <= Codec::MAX_LEVEL; level++) {
+    std::string const what(name + " at level " + std::to_string(level));
+    auto const packed(compress(in, level));
+    if (packed.empty()) {
+      if (shrinks) return failed(what + " did not compress");
+      continue;
+    }
+    if (!shrinks) return failed(what + " compressed");
+    std::vector<uint8_t> out(in.size());
+    Codec::DECOMPRESS(packed.data(), packed.size(), out.data(), out.size());
+    if (out != in) return failed(what + " differs after decompression");
+  }
+  return false;
+}
+
+std::vector<uint8_t> random(size_t const len) {
+  std::vector<uint8_t> data(len);
+  uint64_t x = 0;
+  for (auto& b : data) {  // splitmix64
+    uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    b = static_cast<uint8_t>(z ^ (z >> 31));
+  }
+  return data;
+}
+}  // namespace
+
+int main(int /*argc*/, char* /*argv*/[]) {
+  std::vector<uint8_t> const empty;
+  if (!compress(empty, Codec::MAX_LEVEL).empty()) return failed("empty compressed");
+  if (throws(empty, 0)) return failed("empty did not decompress");
+
+  if (round_trip("incompressible", random(1 << 16), false)) return 1;
+
+  std::vector<uint8_t> repetitive(100000, 'a');
+  if (round_trip("repetitive", repetitive, true)) return 1;
+  std::string const line("#include <vector>\nint main() { return 0; }\n");
+  std::vector<uint8_t> text;
+  while (text.size() < 100000) text.insert(text.end(), line.begin(), line.end());
+  if (round_trip("text", text, true)) return 1;
+  auto mixed(random(1 << 15));
+  mixed.insert(mixed.end(), text.begin(), text.end());
+  if (round_trip("mixed", mixed, true)) return 1;
+
+  // a trailing empty sequence may be dropped, anything shorter loses data
+  auto const packed(compress(text, Codec::MAX_LEVEL));
+  for (size_t n = 1; n + 1 < packed.size(); n++)
+    if (!throws(std::vector<uint8_t>(packed.begin(), packed.begin() + n), text.size()))
+      return failed("truncated to " + std::to_string(n) + " bytes decompressed");
+  if (!throws(packed, text.size() - 1)) return failed("decompressed past the output");
+  if (!throws(packed, text.size() + 1)) return failed("decompressed short of the output");
+
+  if (!throws({0x00, 0x00, 0x00}, 4)) return failed("zero offset decompressed");
+  if (!throws({0x10, 'a', 0x05, 0x00}, 5)) return failed("offset before output decompressed");
+  if (!throws({0xF0, 0x05, 'a'}, 20)) return failed("missing literals decompressed");
+  if (!throws({0xF0, 0xFF}, 300)) return failed("truncated length decompressed");
+
+  return 0;
+}